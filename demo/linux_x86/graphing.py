@@ -1,6 +1,7 @@
 import os
 import random
 import socket
+import struct
 import subprocess as subp
 import sys
 import time
@@ -15,13 +16,22 @@ if __name__ == '__main__':
 	else:
 		NGRAPHS = 10
 
+	# Send graphing_frame.h frames instead of text lines, ROWS_PER_FRAME rows each, so the
+	# header and per-frame handling are spread over many rows (as a producer should)
+	BINARY = "--binary" in sys.argv[2:]
+	ROWS_PER_FRAME = 16
+	# Send datagrams straight to graphing's own UDP listener instead of its stdin
+	UDP = "--udp" in sys.argv[2:]
+
 	sock = socket.socket(family=socket.AF_INET, type=socket.SOCK_DGRAM)
-	sock.bind(("localhost", GRAPHGRID_PORT))
-	print("started server.")
+	if not UDP:
+		sock.bind(("localhost", GRAPHGRID_PORT))
+		print("started server.")
 
 	with open("dump.txt", "w") as fp:
 		os.environ["PYTHONUNBUFFERED"] = "1"
-		graph_sub = subp.Popen([BINFILE, str(NGRAPHS)], text=True, universal_newlines=True, stdin=subp.PIPE, stdout=sys.stdout, stderr=fp)
+		graph_args = [BINFILE, str(NGRAPHS)] + (["--binary"] if BINARY else []) + (["--udp", str(GRAPHGRID_PORT)] if UDP else [])
+		graph_sub = subp.Popen(graph_args, text=not BINARY, universal_newlines=not BINARY, stdin=subp.PIPE, stdout=sys.stdout, stderr=fp)
 
 		def rand_n_ints(a, n):
 			return list(map(str, random.sample(range(-a, a), n ) ))
@@ -48,6 +58,23 @@ if __name__ == '__main__':
 			# ======================
 			amp = random.randint(100, 1000)
 
+			if BINARY:
+				# A datagram has to hold the whole frame
+				rows = ROWS_PER_FRAME if not UDP else max(1, min(ROWS_PER_FRAME, (65507 - 12) // (4 * max(NGRAPHS, len(special)))))
+				vals = []
+				for _ in range(rows):
+					vals += [ii[idx % len(ii)] for ii in special] + [random.uniform(-amp, amp) for _ in range(NGRAPHS - len(special))]
+					idx += 1
+				frame = b"GRPH" + struct.pack("<HHI", len(vals) // rows, 1, rows) + struct.pack(f"<{len(vals)}f", *vals)
+				if UDP:
+					sock.sendto(frame, ("localhost", GRAPHGRID_PORT))
+				else:
+					graph_sub.stdin.write(frame)
+					graph_sub.stdin.flush()
+
+				time.sleep(0.001 * rows) # same row rate as the text mode
+				continue
+
 			ss = ', '.join(
 				[str(ii[idx % len(ii)]) for ii in special]
 				# + rand_n_ints(amp, NGRAPHS - len(special))
@@ -65,8 +92,11 @@ if __name__ == '__main__':
 
 			ss = ss.replace(' ', ", ")
 
-			graph_sub.stdin.write(f"{ss}\n")
-			graph_sub.stdin.flush()			
+			if UDP:
+				sock.sendto(ss.encode(), ("localhost", GRAPHGRID_PORT))
+			else:
+				graph_sub.stdin.write(f"{ss}\n")
+				graph_sub.stdin.flush()
 
 			idx += 1
 			time.sleep(0.001) # Sleep for some time
@@ -1,6 +1,7 @@
 import os
 import random
 import socket
+import struct
 import subprocess as subp
 import sys
 import time
@@ -15,13 +16,19 @@ if __name__ == '__main__':
 	else:
 		NGRAPHS = 10
 
+	# Send graphing_frame.h frames instead of text lines, ROWS_PER_FRAME rows each, so the
+	# header and per-frame handling are spread over many rows (as a producer should)
+	BINARY = "--binary" in sys.argv[2:]
+	ROWS_PER_FRAME = 16
+
 	sock = socket.socket(family=socket.AF_INET, type=socket.SOCK_DGRAM)
 	sock.bind(("localhost", GRAPHGRID_PORT))
 	print("started server.")
 
 	with open("dump.txt", "w") as fp:
 		os.environ["PYTHONUNBUFFERED"] = "1"
-		graph_sub = subp.Popen([BINFILE, str(NGRAPHS)], text=True, universal_newlines=True, stdin=subp.PIPE, stdout=sys.stdout, stderr=fp)
+		graph_args = [BINFILE, str(NGRAPHS)] + (["--binary"] if BINARY else [])
+		graph_sub = subp.Popen(graph_args, text=not BINARY, universal_newlines=not BINARY, stdin=subp.PIPE, stdout=sys.stdout, stderr=fp)
 
 		def rand_n_ints(a, n):
 			return list(map(str, random.sample(range(-a, a), n ) ))
@@ -48,6 +55,17 @@ if __name__ == '__main__':
 			# ======================
 			amp = random.randint(100, 1000)
 
+			if BINARY:
+				vals = []
+				for _ in range(ROWS_PER_FRAME):
+					vals += [ii[idx % len(ii)] for ii in special] + [random.uniform(-amp, amp) for _ in range(NGRAPHS - len(special))]
+					idx += 1
+				graph_sub.stdin.write(b"GRPH" + struct.pack("<HHI", len(vals) // ROWS_PER_FRAME, 1, ROWS_PER_FRAME) + struct.pack(f"<{len(vals)}f", *vals))
+				graph_sub.stdin.flush()
+
+				time.sleep(0.001 * ROWS_PER_FRAME) # same row rate as the text mode
+				continue
+
 			ss = ', '.join(
 				[str(ii[idx % len(ii)]) for ii in special]
 				# + rand_n_ints(amp, NGRAPHS - len(special))
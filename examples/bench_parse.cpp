@@ -0,0 +1,102 @@
+/*
+ *	Lines per second parsed by parse_row() (graphing_parse.h) against the
+ *	string_split() + strtof() loop graphing used before it.
+ *
+ *	usage: ./bench_parse [columns] [lines]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "graphing_parse.h"
+
+#define DELIM ","
+
+
+/* How graphing split lines before parse_row(): one std::string per field */
+std::vector<std::string> string_split(std::string& ss, const char* delim)
+{
+	size_t pos_start = 0;
+	size_t pos_end;
+	size_t delim_len = strlen(delim);
+	std::string buff;
+	std::vector<std::string> res;
+
+	while ((pos_end = ss.find(delim, pos_start)) != std::string::npos) {
+		buff = ss.substr(pos_start, pos_end - pos_start);
+		pos_start = pos_end + delim_len;
+		res.push_back(buff);
+	}
+
+	buff = ss.substr(pos_start);
+	if (buff.length() > 0)
+		res.push_back(buff);
+	return res;
+}
+
+
+/* */
+double now_seconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* */
+int main(int argc, char** argv)
+{
+	const int ncols = (argc > 1) ? atoi(argv[1]) : 24;
+	const int nlines = (argc > 2) ? atoi(argv[2]) : 200000;
+	if (ncols < 1 || nlines < 1) {
+		printf("usage: %s [columns] [lines]\n", argv[0]);
+		return 1;
+	}
+
+	// Random values printed with full precision, like a producer that doesn't round
+	std::vector<std::string> lines(nlines);
+	srand(1);
+	for (int i = 0; i < nlines; i++) {
+		char buff[32];
+		for (int c = 0; c < ncols; c++) {
+			snprintf(buff, sizeof(buff), "%.17g", (rand() / (double) RAND_MAX - 0.5) * 2000.0);
+			lines[i] += buff;
+			if (c + 1 < ncols)
+				lines[i] += DELIM;
+		}
+	}
+
+	std::vector<float> before((size_t) nlines * ncols);
+	std::vector<float> after((size_t) nlines * ncols);
+
+	double t0 = now_seconds();
+	for (int i = 0; i < nlines; i++) {
+		std::vector<std::string> separated = string_split(lines[i], DELIM);
+		for (int c = 0; c < ncols; c++)
+			before[(size_t) i * ncols + c] = strtof(separated[c].c_str(), NULL);
+	}
+	const double t_before = now_seconds() - t0;
+
+	t0 = now_seconds();
+	for (int i = 0; i < nlines; i++) {
+		const char* line = lines[i].c_str();
+		parse_row(line, line + lines[i].size(), DELIM, sizeof(DELIM) - 1, &after[(size_t) i * ncols], ncols);
+	}
+	const double t_after = now_seconds() - t0;
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < before.size(); i++)
+		mismatches += (before[i] != after[i]);
+
+	printf("%d columns, %d lines\n", ncols, nlines);
+	printf("  string_split + strtof: %10.0f lines/s\n", nlines / t_before);
+	printf("  parse_row:             %10.0f lines/s (x%.1f)\n", nlines / t_after, t_before / t_after);
+	printf("  values differing from strtof: %zu\n", mismatches);
+	return mismatches != 0;
+}
@@ -0,0 +1,77 @@
+/*
+ *	Nanoseconds per point of the kernels turning points into screen y coordinates
+ *	(graph_transform_y_*), at graph sizes of 500, 10k and 1M points.
+ *
+ *	usage: ./bench_transform [seconds per measurement]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+#include <graphing.h>
+
+typedef void (*transform_fn)(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale);
+
+// Called through this so the compiler can't inline the kernel and drop repeated work
+transform_fn volatile g_fn;
+
+
+/* Best of a few rounds, each repeating the transform for about `seconds` */
+double ns_per_point(transform_fn fn, SDL_FPoint* out, const float* ys, int n, double seconds)
+{
+	const double freq = (double) SDL_GetPerformanceFrequency();
+	double best = 1e30;
+	g_fn = fn;
+
+	for (int round = 0; round < 5; round++) {
+		long long points = 0;
+		const uint64_t start = SDL_GetPerformanceCounter();
+		uint64_t now = start;
+		while ((now - start) / freq < seconds / 5) {
+			for (int rep = 0; rep < 16; rep++)
+				g_fn(out, ys, n, 240.0f + rep, 0.37f);
+			points += 16LL * n;
+			now = SDL_GetPerformanceCounter();
+		}
+		const double ns = (now - start) / freq * 1e9 / points;
+		if (ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+
+/* */
+int main(int argc, char** argv)
+{
+	const double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	const int sizes[] = {500, 10000, 1000000};
+
+	printf("ns per point        scalar     sse2     avx2  dispatch\n");
+	for (int s = 0; s < (int) ARR_SIZE(sizes); s++) {
+		const int n = sizes[s];
+		float* ys = (float*) malloc(sizeof(float) * n);
+		SDL_FPoint* out = (SDL_FPoint*) malloc(sizeof(SDL_FPoint) * n);
+		for (int i = 0; i < n; i++) {
+			ys[i] = (float)(rand() % 2000 - 1000);
+			out[i] = (SDL_FPoint){(float) i, 0.0f};
+		}
+
+		printf("n=%-9d %12.2f", n, ns_per_point(graph_transform_y_scalar_, out, ys, n, seconds));
+		#ifdef GRAPHING_SIMD
+			printf(" %8.2f", ns_per_point(graph_transform_y_sse2_, out, ys, n, seconds));
+			if (SDL_HasAVX2())
+				printf(" %8.2f", ns_per_point(graph_transform_y_avx2_, out, ys, n, seconds));
+			else
+				printf(" %8s", "-");
+		#else
+			printf(" %8s %8s", "-", "-");
+		#endif
+		printf(" %9.2f\n", ns_per_point(graph_transform_y_, out, ys, n, seconds));
+
+		free(ys);
+		free(out);
+	}
+	return 0;
+}
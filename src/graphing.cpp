@@ -14,10 +14,32 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
 
 #include <vector>
-#include <iostream> // getline(cin) for data
 #include <string>
+#include <deque>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <windows.h> // file mapping
+	#define read_stdin(buf, n) _read(0, (buf), (unsigned int)(n))
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <signal.h>
+	#define read_stdin(buf, n) read(0, (buf), (n))
+#endif
+
+#ifdef __linux__
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include "graphing_shm.h"
+#endif
 
 #define SDL_MAIN_HANDLED
 #include "SDL2/SDL.h"
@@ -30,6 +52,8 @@
 
 #define GRAPHING_NO_AUTO_WIN_UPDATES
 #include "graphing.h"
+#include "graphing_frame.h"
+#include "graphing_parse.h"
 
 #include "cJSON/cJSON.h"
 
@@ -56,9 +80,55 @@
 
 #define DELIM ", "
 
+#define INPUT_CHUNK_SIZE (1 << 20) // bytes requested from stdin per read()
+#define INPUT_BATCH_ROWS 1024      // rows handed to the graphs at once
+
+#define RENDER_DEFAULT_FPS 60
+#define RENDER_STATS_INTERVAL 5000 // ms between --stats reports
+#define RENDER_IDLE_TIMEOUT 250    // ms the idle render thread sleeps before checking g_running
+
+#define EXPORT_POOL_SIZE 4         // frames read back but not written out yet, beyond that frames are dropped
+#define EXPORT_QUEUE_LIMIT 256     // frames (mostly repeats of an unchanged one) waiting for the writer
+
+#define UDP_DEFAULT_PORT 5056
+#define UDP_MMSG_COUNT 64          // datagrams pulled per recvmmsg()
+#define UDP_MAX_DATAGRAM 65536
+
+typedef struct {
+	const char* target;        // "|command", "name%06d.ppm" or a path (e.g. a fifo)
+	FILE* out;                 // raw RGB stream, NULL when writing numbered PPM files
+	uint8_t piped;
+	int width;
+	int height;
+	std::string name_prefix;   // numbered files: what comes before and after the number,
+	std::string name_suffix;   //   zero padded to name_digits
+	int name_digits;
+
+	std::vector<uint8_t> frames[EXPORT_POOL_SIZE]; // ARGB8888 as read back
+	std::vector<int> free_frames;
+	std::deque<int> ready_frames;                  // oldest first, -1 repeats the frame before
+	SDL_mutex* lock;
+	SDL_cond* cond;
+	uint8_t quit;
+
+	uint64_t captured;
+	uint64_t dropped;
+	SDL_Thread* thread;
+} frame_export_t;
+
 typedef struct {
 	std::vector<graph_t*> * graph_list;
 	// SDL_mutex* mutex;
+	uint8_t binary;            // input carries graphing_frame.h frames instead of text
+	const char* udp;           // "[addr:]port" to listen on instead of reading stdin, or NULL
+	const char* shm;           // graphing_shm.h segment to drain instead of reading stdin, or NULL
+	const char* file;          // dataset to plot all in one go instead of reading stdin, or NULL
+	graph_dashboard_t* dashboard; // all graphs are tiles of this one window, or NULL for a window each
+	int fps;                   // target frame rate of the render thread
+	uint8_t stats;             // periodically print the achieved frame rate of every window
+	SDL_sem* wakeup;           // posted by the graphs on new points and by the main loop on expose
+	frame_export_t* exporter;  // every drawn dashboard frame is handed to it, or NULL
+	graph_pool_t* pool;        // graphs are rasterized on the CPU by these threads, or NULL
 } graph_control_t;
 
 uint8_t g_running = 1;
@@ -66,87 +136,983 @@ uint8_t g_render_thread_done = 0;
 uint8_t g_input_thread_done = 0;
 uint8_t g_render_paused = 0;
 
+typedef struct {
+	std::vector<graph_t*>* graph_list;
+	int ncols;                 // values per row (= series of all graphs)
+	int nrows;                 // rows currently held
+	std::vector<float> rows;   // INPUT_BATCH_ROWS * ncols, row-major
+} row_batch_t;
 
-/* */
-std::vector<std::string> string_split(std::string& ss, const char* delim)
+typedef struct {
+	uint32_t rows_left;        // rows of the current frame not decoded yet
+	int channels;
+	int dtype;
+} frame_state_t;
+
+typedef struct {
+	size_t offset;             // of the frame's first row
+	uint64_t first_row;        // dataset row index of the frame's first row
+	uint32_t rows;
+	int channels;
+	int dtype;
+} frame_index_t;
+
+typedef struct {
+	const char* data;          // whole file, mapped read-only
+	size_t size;
+	uint8_t binary;
+	uint64_t nrows;
+	std::vector<size_t> lines;           // text: offset of every non-empty line
+	std::vector<frame_index_t> frames;   // binary: every frame with enough channels
+	#ifdef _WIN32
+	HANDLE hfile, hmap;
+	#endif
+} dataset_t;
+
+
+/* Input channels the graphs take, one per series */
+int count_channels(std::vector<graph_t*>* graph_list)
 {
-	size_t pos_start = 0;
-	size_t pos_end;
-	size_t delim_len = strlen(delim);
-	std::string buff;
-	std::vector<std::string> res;
-
-	while ((pos_end = ss.find(delim, pos_start)) != std::string::npos) {
-		buff = ss.substr(pos_start, pos_end - pos_start);
-		pos_start = pos_end + delim_len;
-		res.push_back(buff);
-	}
-
-	buff = ss.substr(pos_start);
-	if (buff.length() > 0)
-		res.push_back(buff);
-	return res;
+	int channels = 0;
+	for (graph_t* gr : *graph_list)
+		channels += gr->series;
+	return channels;
 }
 
 
 /* */
+void batch_init(row_batch_t* batch, std::vector<graph_t*>* graph_list)
+{
+	batch->graph_list = graph_list;
+	batch->ncols = count_channels(graph_list);
+	batch->nrows = 0;
+	batch->rows.resize((size_t) INPUT_BATCH_ROWS * batch->ncols);
+}
+
+
+/* Hands all rows collected so far over to the graphs */
+void batch_flush(row_batch_t* batch)
+{
+	graph_appendrows(batch->graph_list->data(), (int) batch->graph_list->size(), batch->rows.data(), batch->nrows, batch->ncols);
+	batch->nrows = 0;
+}
+
+
+/* Parses one line into the batch; returns 0 if the line was "exit" */
+int batch_add_line(row_batch_t* batch, const char* line, const char* end)
+{
+	if (end - line >= 4 && memcmp(line, "exit", 4) == 0) {
+		const char* rest = line + 4;
+		while (rest < end && (*rest == '\r' || *rest == ' '))
+			rest++;
+		if (rest == end)
+			return 0;
+	}
+
+	float* row = batch->rows.data() + batch->nrows * batch->ncols;
+	if (parse_row(line, end, DELIM, sizeof(DELIM) - 1, row, batch->ncols) < batch->ncols)
+		return 1; // Silently ignore packet
+
+	if (++batch->nrows == INPUT_BATCH_ROWS)
+		batch_flush(batch);
+	return 1;
+}
+
+
+/* Feeds every complete line in [buf, buf+len) to the batch; returns the number of bytes
+ * consumed (everything up to and including the last '\n'), or -1 on "exit" */
+long batch_add_lines(row_batch_t* batch, const char* buf, size_t len)
+{
+	const char* p = buf;
+	const char* end = buf + len;
+	const char* nl;
+
+	while ((nl = (const char*) memchr(p, '\n', end - p)) != NULL) {
+		if (!batch_add_line(batch, p, nl))
+			return -1;
+		p = nl + 1;
+	}
+	return (long)(p - buf);
+}
+
+
+/* Converts the first ncols values of one little-endian frame row to floats */
+void decode_frame_row(const char* row, int dtype, float* dst, int ncols)
+{
+	for (int i = 0; i < ncols; i++) {
+		switch (dtype) {
+			case GRAPHING_DTYPE_F32: {
+				float v;
+				memcpy(&v, row + 4 * i, 4);
+				dst[i] = SDL_SwapFloatLE(v);
+			} break;
+			case GRAPHING_DTYPE_I16: {
+				uint16_t v;
+				memcpy(&v, row + 2 * i, 2);
+				dst[i] = (float)(int16_t) SDL_SwapLE16(v);
+			} break;
+			case GRAPHING_DTYPE_I32: {
+				uint32_t v;
+				memcpy(&v, row + 4 * i, 4);
+				dst[i] = (float)(int32_t) SDL_SwapLE32(v);
+			} break;
+		}
+	}
+}
+
+
+/* Converts n rows of a frame's payload into the batch, keeping the first batch->ncols channels */
+void batch_add_frame_rows(row_batch_t* batch, const char* src, uint32_t n, int channels, int dtype)
+{
+	const int ncols = batch->ncols;
+	const size_t rowbytes = (size_t) channels * graphing_dtype_size(dtype);
+
+	while (n > 0) {
+		uint32_t take = INPUT_BATCH_ROWS - batch->nrows;
+		if (take > n)
+			take = n;
+		float* dst = batch->rows.data() + batch->nrows * ncols;
+
+		if (dtype == GRAPHING_DTYPE_F32 && channels == ncols && SDL_BYTEORDER == SDL_LIL_ENDIAN) {
+			memcpy(dst, src, take * rowbytes);
+		} else {
+			for (uint32_t r = 0; r < take; r++, dst += ncols)
+				decode_frame_row(src + r * rowbytes, dtype, dst, ncols);
+		}
+
+		src += take * rowbytes;
+		n -= take;
+		if ((batch->nrows += take) == INPUT_BATCH_ROWS)
+			batch_flush(batch);
+	}
+}
+
+
+/* Decodes as many whole rows of graphing_frame.h frames as [buf, buf+len) holds; returns
+ * the number of bytes consumed. Frames may be split across calls at any byte. */
+long batch_add_frames(row_batch_t* batch, frame_state_t* fs, const char* buf, size_t len)
+{
+	const char* p = buf;
+	const char* end = buf + len;
+
+	for (;;) {
+		if (fs->rows_left == 0) {
+			if (end - p < GRAPHING_FRAME_HEADER_SIZE)
+				break;
+
+			if (memcmp(p, GRAPHING_FRAME_MAGIC, 4) != 0) {
+				// Out of sync, skip to the next possible magic
+				const char* m = (const char*) memchr(p + 1, GRAPHING_FRAME_MAGIC[0], end - p - 1);
+				p = (m != NULL) ? m : end;
+				continue;
+			}
+
+			graphing_frame_header_t hdr;
+			memcpy(&hdr, p, sizeof(hdr));
+			fs->channels = SDL_SwapLE16(hdr.channels);
+			fs->dtype = SDL_SwapLE16(hdr.dtype);
+			fs->rows_left = SDL_SwapLE32(hdr.samples);
+
+			if (fs->channels == 0 || graphing_dtype_size(fs->dtype) == 0) {
+				fs->rows_left = 0;
+				p++; // bogus header, resync
+				continue;
+			}
+			p += GRAPHING_FRAME_HEADER_SIZE;
+		}
+
+		const size_t rowbytes = (size_t) fs->channels * graphing_dtype_size(fs->dtype);
+		uint32_t n = (uint32_t)((end - p) / rowbytes);
+		if (n > fs->rows_left)
+			n = fs->rows_left;
+		if (n == 0)
+			break;
+
+		// Rows that are too short for all graphs are silently ignored, just like text lines
+		if (fs->channels >= batch->ncols)
+			batch_add_frame_rows(batch, p, n, fs->channels, fs->dtype);
+
+		p += n * rowbytes;
+		fs->rows_left -= n;
+	}
+
+	return (long)(p - buf);
+}
+
+
+/*
+ *  Reads stdin in large blocks with read() rather than line by line, so a
+ *  producer dumping a recorded dataset costs one syscall per INPUT_CHUNK_SIZE
+ *  bytes. A read() on a pipe returns whatever is available, so live input is
+ *  not held back waiting for the block to fill up.
+ */
 int threaded_input(void* data)
 {
 	std::vector<graph_t*>* graph_list = ((graph_control_t*) data)->graph_list;
 	// SDL_mutex* mainmutex = ((graph_control_t*) data)->mutex;
+	const uint8_t binary = ((graph_control_t*) data)->binary;
+
+	row_batch_t batch;
+	batch_init(&batch, graph_list);
+
+	frame_state_t frame = {0, 0, 0};
 
-	std::string buff;
-	std::vector<std::string> separated;
-	float yvalf;
+	std::vector<char> chunk(INPUT_CHUNK_SIZE);
+	size_t have = 0;          // bytes of an incomplete line/row carried over from the last read
+	uint8_t skipping = 0;     // currently dropping a line longer than the whole chunk
 
 	while (g_running) {
-		std::getline(std::cin, buff); // Kinda blocks :/
+		long nread = read_stdin(chunk.data() + have, chunk.size() - have); // Kinda blocks :/
 
-		if (!g_running) // repeat check because getline blocks
+		if (!g_running) // repeat check because read blocks
 			break;
 
-		if (buff == "exit") {
+		if (nread < 0 && errno == EINTR) // a signal came in before any data did
+			continue;
+
+		if (nread <= 0) {
+			// EOF: the last line might not have a '\n'
+			if (!binary && have > 0 && !skipping && !batch_add_line(&batch, chunk.data(), chunk.data() + have))
+				g_running = 0;
+			break;
+		}
+		have += nread;
+
+		const char* buf = chunk.data();
+		if (skipping) {
+			const char* nl = (const char*) memchr(buf, '\n', have);
+			if (nl == NULL) {
+				have = 0;
+				continue;
+			}
+			skipping = 0;
+			have -= (nl + 1) - buf;
+			memmove(chunk.data(), nl + 1, have);
+		}
+
+		long used = binary ? batch_add_frames(&batch, &frame, buf, have)
+		                   : batch_add_lines(&batch, buf, have);
+		if (used < 0) {
 			g_running = 0;
 			break;
 		}
+		batch_flush(&batch);
+
+		// Carry the partial tail over to the next read
+		have -= used;
+		if (have == chunk.size()) {
+			have = 0;
+			skipping = !binary;
+		} else if (used > 0 && have > 0) {
+			memmove(chunk.data(), buf + used, have);
+		}
+	}
+
+	batch_flush(&batch);
+	g_input_thread_done = 1;
+	return 0;
+}
+
+
+#ifdef __linux__
+/*
+ *  Listens for datagrams directly so producers don't need to go through
+ *  something that forwards them to stdin. Each datagram holds one or more
+ *  complete rows (text lines, the last '\n' optional, or whole binary frames).
+ *  recvmmsg() pulls up to UDP_MMSG_COUNT datagrams per syscall and all of
+ *  them are handed to the graphs as one batch.
+ */
+int threaded_udp(void* data)
+{
+	graph_control_t* ctl = (graph_control_t*) data;
+
+	// "[addr:]port", loopback only unless told otherwise
+	char addrbuff[64+1] = "127.0.0.1";
+	int port = UDP_DEFAULT_PORT;
+	const char* colon = strrchr(ctl->udp, ':');
+	if (colon != NULL) {
+		snprintf(addrbuff, sizeof(addrbuff), "%.*s", (int)(colon - ctl->udp), ctl->udp);
+		port = atoi(colon + 1);
+	} else if (ctl->udp[0] != '\0') {
+		port = atoi(ctl->udp);
+	}
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, addrbuff, &addr.sin_addr) != 1) {
+		printf("Invalid UDP address '%s'\n", addrbuff);
+		g_input_thread_done = 1;
+		return 1;
+	}
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0 || bind(sock, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+		printf("Could not listen on udp %s:%d! (%s)\n", addrbuff, port, strerror(errno));
+		if (sock >= 0)
+			close(sock);
+		g_input_thread_done = 1;
+		return 1;
+	}
+	printf("Listening on udp %s:%d\n", addrbuff, port);
+
+	// Wake up every now and then to notice g_running going down
+	struct timeval tv = {0, 100 * 1000};
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	int rcvbuf = 8 << 20;
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	row_batch_t batch;
+	batch_init(&batch, ctl->graph_list);
+
+	std::vector<char> bufs((size_t) UDP_MMSG_COUNT * UDP_MAX_DATAGRAM);
+	struct iovec iovs[UDP_MMSG_COUNT];
+	struct mmsghdr msgs[UDP_MMSG_COUNT];
+	memset(msgs, 0, sizeof(msgs));
+	for (int i = 0; i < UDP_MMSG_COUNT; i++) {
+		iovs[i].iov_base = bufs.data() + (size_t) i * UDP_MAX_DATAGRAM;
+		iovs[i].iov_len = UDP_MAX_DATAGRAM;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
 
-		separated = string_split(buff, DELIM);
-		if (separated.size() < graph_list->size()) {
-			continue; // Silently ignore packet
+	while (g_running) {
+		int got = recvmmsg(sock, msgs, UDP_MMSG_COUNT, MSG_WAITFORONE, NULL);
+		if (got < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				continue;
+			printf("recvmmsg error: %s\n", strerror(errno));
+			break;
 		}
 
-		for (size_t i = 0; i < graph_list->size(); i++) {
-			yvalf = strtof(separated[i].c_str(), NULL);
-			graph_appendpoint(graph_list->at(i), yvalf);
+		for (int i = 0; i < got && g_running; i++) {
+			const char* dgram = (const char*) iovs[i].iov_base;
+			size_t len = msgs[i].msg_len;
+
+			if (ctl->binary) {
+				frame_state_t frame = {0, 0, 0}; // frames never span datagrams
+				batch_add_frames(&batch, &frame, dgram, len);
+				continue;
+			}
+
+			long used = batch_add_lines(&batch, dgram, len);
+			if (used < 0 || ((size_t) used < len && !batch_add_line(&batch, dgram + used, dgram + len)))
+				g_running = 0; // "exit"
 		}
+
+		batch_flush(&batch);
 	}
+
+	close(sock);
 	g_input_thread_done = 1;
 	return 0;
 }
+#endif
+
+
+#ifdef __linux__
+/*
+ *  Drains a graphing_shm.h ring filled by a producer on the same machine.
+ *  Rows are appended to the graphs straight out of the shared mapping, there
+ *  is no intermediate copy. Waits for the producer to create the segment,
+ *  goes back to waiting if it goes away and attaches again if a restarted
+ *  producer recreates it.
+ */
+int threaded_shm(void* data)
+{
+	graph_control_t* ctl = (graph_control_t*) data;
+	const int ngraphs = (int) ctl->graph_list->size();
+	const int channels = count_channels(ctl->graph_list);
+
+	graphing_shm_t* shm = NULL;
+	uint8_t said_waiting = 0;
+
+	while (g_running) {
+		if (shm == NULL) {
+			if ((shm = graphing_shm_open(ctl->shm)) == NULL) {
+				if (!said_waiting) {
+					printf("Waiting for shared memory segment '%s'...\n", ctl->shm);
+					said_waiting = 1;
+				}
+				SDL_Delay(250);
+				continue;
+			}
+
+			printf("Attached to '%s' (%u channels, %u rows)\n", ctl->shm, shm->channels, shm->capacity);
+			said_waiting = 0;
+			if ((int) shm->channels < channels)
+				printf("Segment has fewer channels than graphs, its rows will be ignored!\n");
+		}
+
+		// A restarted producer reset the ring (maybe to another size) under us
+		if (graphing_shm_stale(shm)) {
+			printf("Producer recreated '%s'\n", ctl->shm);
+			graphing_shm_close(shm);
+			shm = NULL;
+			continue;
+		}
+
+		const float* rows;
+		uint32_t n = graphing_shm_peek(shm, &rows);
+		if (n == 0) {
+			if (!__atomic_load_n(&shm->hdr->closed, __ATOMIC_ACQUIRE)) {
+				SDL_Delay(1);
+				continue;
+			}
+			// Rows pushed right before closing still count
+			if ((n = graphing_shm_peek(shm, &rows)) == 0) {
+				printf("Producer closed '%s'\n", ctl->shm);
+				graphing_shm_close(shm);
+				shm = NULL;
+				continue;
+			}
+		}
+
+		if ((int) shm->channels >= channels)
+			graph_appendrows(ctl->graph_list->data(), ngraphs, rows, (int) n, (int) shm->channels);
+		graphing_shm_release(shm, n);
+	}
+
+	graphing_shm_close(shm);
+	g_input_thread_done = 1;
+	return 0;
+}
+#endif
+
+
+/*
+ *  Dataset files (--file)
+ *  ======================
+ *  The whole file is mapped instead of read, indexed in a single pass
+ *  (line offsets for text, frame offsets for --binary/GRPH files) and then
+ *  parsed by a few threads, each filling its own range of every graph's
+ *  buffer directly. Nothing of the raw file is ever copied to the heap.
+ */
+
+/* Maps `path` read-only; returns 0 on success */
+int dataset_map(dataset_t* ds, const char* path)
+{
+	ds->data = NULL;
+	ds->size = 0;
+
+#ifdef _WIN32
+	ds->hmap = NULL;
+	ds->hfile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (ds->hfile == INVALID_HANDLE_VALUE)
+		return 1;
+
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx(ds->hfile, &fsize))
+		fsize.QuadPart = -1;
+	ds->size = (fsize.QuadPart > 0) ? (size_t) fsize.QuadPart : 0;
+	if (fsize.QuadPart == 0)
+		return 0;
+
+	if (fsize.QuadPart > 0)
+		ds->hmap = CreateFileMappingA(ds->hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (ds->hmap != NULL)
+		ds->data = (const char*) MapViewOfFile(ds->hmap, FILE_MAP_READ, 0, 0, 0);
+	if (ds->data == NULL) {
+		// Nothing is left open for dataset_unmap(), callers don't call it on failure
+		if (ds->hmap != NULL)
+			CloseHandle(ds->hmap);
+		CloseHandle(ds->hfile);
+		ds->hmap = NULL;
+		ds->hfile = INVALID_HANDLE_VALUE;
+		ds->size = 0;
+		return 1;
+	}
+	return 0;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 1;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return 1;
+	}
+	ds->size = (size_t) st.st_size;
+	if (ds->size == 0) {
+		close(fd);
+		return 0;
+	}
+
+	void* mem = mmap(NULL, ds->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		return 1;
+
+	madvise(mem, ds->size, MADV_SEQUENTIAL | MADV_WILLNEED);
+	ds->data = (const char*) mem;
+	return 0;
+#endif
+}
 
 
 /* */
-int threaded_render(void* glist)
+void dataset_unmap(dataset_t* ds)
 {
-	auto graph_list = (std::vector<graph_t*>*) glist;
+#ifdef _WIN32
+	if (ds->data != NULL)
+		UnmapViewOfFile(ds->data);
+	if (ds->hmap != NULL)
+		CloseHandle(ds->hmap);
+	if (ds->hfile != INVALID_HANDLE_VALUE)
+		CloseHandle(ds->hfile);
+#else
+	if (ds->data != NULL)
+		munmap((void*) ds->data, ds->size);
+#endif
+	ds->data = NULL;
+	ds->lines.clear();
+	ds->frames.clear();
+}
 
-	uint64_t startticks;
-	uint64_t nowticks;
 
-	const int framedelay = (float)1000 / 60;
+/* Finds where every row starts; rows with fewer than ncols fields are left out, just like
+ * batch_add_line() drops them when streaming */
+void dataset_index(dataset_t* ds, int ncols)
+{
+	const char* p = ds->data;
+	const char* end = ds->data + ds->size;
+	ds->nrows = 0;
+
+	if (ds->binary) {
+		while (end - p >= GRAPHING_FRAME_HEADER_SIZE) {
+			if (memcmp(p, GRAPHING_FRAME_MAGIC, 4) != 0) {
+				const char* m = (const char*) memchr(p + 1, GRAPHING_FRAME_MAGIC[0], end - p - 1);
+				p = (m != NULL) ? m : end;
+				continue;
+			}
+
+			graphing_frame_header_t hdr;
+			memcpy(&hdr, p, sizeof(hdr));
+			frame_index_t fr;
+			fr.channels = SDL_SwapLE16(hdr.channels);
+			fr.dtype = SDL_SwapLE16(hdr.dtype);
+			fr.rows = SDL_SwapLE32(hdr.samples);
+			fr.offset = (p - ds->data) + GRAPHING_FRAME_HEADER_SIZE;
+			fr.first_row = ds->nrows;
+
+			const size_t rowbytes = (size_t) fr.channels * graphing_dtype_size(fr.dtype);
+			if (rowbytes == 0) {
+				p++;
+				continue;
+			}
+
+			// A truncated last frame keeps the rows that made it
+			const size_t avail = (size_t)(end - p - GRAPHING_FRAME_HEADER_SIZE) / rowbytes;
+			if (fr.rows > avail)
+				fr.rows = (uint32_t) avail;
+
+			if (fr.channels >= ncols && fr.rows > 0) {
+				ds->frames.push_back(fr);
+				ds->nrows += fr.rows;
+			}
+			p += GRAPHING_FRAME_HEADER_SIZE + fr.rows * rowbytes;
+		}
+		return;
+	}
+
+	ds->lines.reserve(ds->size / 64);
+	while (p < end) {
+		const char* nl = (const char*) memchr(p, '\n', end - p);
+		if (nl == NULL)
+			nl = end;
+		if (row_has_fields(p, nl, DELIM, sizeof(DELIM) - 1, ncols)) // also skips empty lines
+			ds->lines.push_back(p - ds->data);
+		p = nl + 1;
+	}
+	ds->nrows = ds->lines.size();
+}
+
+
+typedef struct {
+	dataset_t* ds;
+	std::vector<graph_t*>* graph_list;
+	uint64_t first;            // dataset row that lands at index 0 of the graphs
+	uint64_t begin, end;       // range of graph indices this worker fills
+} dataset_job_t;
+
+
+/* Parses rows [first+begin, first+end) straight into every graph's points */
+int dataset_fill_range(void* data)
+{
+	dataset_job_t* job = (dataset_job_t*) data;
+	dataset_t* ds = job->ds;
+	const int ncols = count_channels(job->graph_list);
+	const char* fend = ds->data + ds->size;
+
+	std::vector<float*> cols;
+	for (graph_t* gr : *job->graph_list)
+		for (int k = 0; k < gr->series; k++)
+			cols.push_back(gr->points_f + (size_t) k * gr->graph_n);
+	std::vector<float> row(ncols);
+
+	if (ds->binary) {
+		// Frame holding the first row of the range
+		uint64_t r = job->first + job->begin;
+		size_t fi = 0, lo = 0, hi = ds->frames.size();
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if (ds->frames[mid].first_row <= r) {
+				fi = mid;
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		for (uint64_t x = job->begin; x < job->end; x++, r++) {
+			while (r >= ds->frames[fi].first_row + ds->frames[fi].rows)
+				fi++;
+			const frame_index_t* fr = &ds->frames[fi];
+			const size_t rowbytes = (size_t) fr->channels * graphing_dtype_size(fr->dtype);
+			decode_frame_row(ds->data + fr->offset + (r - fr->first_row) * rowbytes, fr->dtype, row.data(), ncols);
+			for (int i = 0; i < ncols; i++)
+				cols[i][x] = row[i];
+		}
+		return 0;
+	}
+
+	for (uint64_t x = job->begin; x < job->end; x++) {
+		const char* line = ds->data + ds->lines[job->first + x];
+		const char* nl = (const char*) memchr(line, '\n', fend - line);
+		parse_row(line, nl ? nl : fend, DELIM, sizeof(DELIM) - 1, row.data(), ncols); // indexed rows have all ncols
+		for (int i = 0; i < ncols; i++)
+			cols[i][x] = row[i];
+	}
+	return 0;
+}
+
+
+/* Fills all graphs (each holding graph_n points) with the last graph_n rows of the dataset */
+void dataset_fill(dataset_t* ds, std::vector<graph_t*>* graph_list)
+{
+	if (graph_list->empty() || ds->nrows == 0)
+		return;
+
+	const uint64_t n = graph_list->at(0)->graph_n;
+	const uint64_t count = (ds->nrows < n) ? ds->nrows : n;
+	const uint64_t first = ds->nrows - count;
+
+	int nthreads = SDL_GetCPUCount();
+	if (nthreads < 1)
+		nthreads = 1;
+	if ((uint64_t) nthreads > count / 4096 + 1)
+		nthreads = (int)(count / 4096 + 1); // not worth it for small files
+
+	std::vector<dataset_job_t> jobs(nthreads);
+	std::vector<SDL_Thread*> threads(nthreads, (SDL_Thread*) NULL);
+	for (int t = 0; t < nthreads; t++) {
+		jobs[t] = (dataset_job_t){ds, graph_list, first, count * t / nthreads, count * (t + 1) / nthreads};
+		if (t > 0)
+			threads[t] = SDL_CreateThread(dataset_fill_range, "dataset thread", (void*) &jobs[t]);
+	}
+	dataset_fill_range((void*) &jobs[0]);
+	for (int t = 1; t < nthreads; t++)
+		SDL_WaitThread(threads[t], NULL);
+
+	// Oldest row sits at index 0, so the next append goes right after the newest one
+	for (graph_t* gr : *graph_list) {
+		graph_claim_(gr, (int) count);
+		gr->pos = (int)(count % gr->graph_n);
+		graph_stats_rebuild_(gr, (int)((count < (uint64_t) gr->graph_n) ? count : gr->graph_n));
+		graph_stats_publish_(gr);
+		graph_publish_(gr, (int) count);
+	}
+}
+
+
+/* Writer thread: converts read back frames to RGB and writes them out, in order */
+int threaded_export(void* data)
+{
+	frame_export_t* ex = (frame_export_t*) data;
+	const int w = ex->width;
+	const int h = ex->height;
+	std::vector<uint8_t> rgb((size_t) w * h * 3);
+	uint8_t failed = 0;
+	uint64_t number = 0;
+	char path[1024];
+
+	while (1) {
+		SDL_LockMutex(ex->lock);
+		while (ex->ready_frames.empty() && !ex->quit)
+			SDL_CondWait(ex->cond, ex->lock);
+		if (ex->ready_frames.empty()) {
+			SDL_UnlockMutex(ex->lock);
+			break;
+		}
+		int idx = ex->ready_frames.front();
+		ex->ready_frames.pop_front();
+		SDL_UnlockMutex(ex->lock);
+
+		if (idx >= 0)
+			SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_ARGB8888, ex->frames[idx].data(), w * 4, SDL_PIXELFORMAT_RGB24, rgb.data(), w * 3);
+
+		if (!failed) {
+			if (ex->out != NULL) {
+				failed = fwrite(rgb.data(), 1, rgb.size(), ex->out) != rgb.size();
+			} else {
+				snprintf(path, sizeof(path), "%s%0*llu%s", ex->name_prefix.c_str(), ex->name_digits,
+					(unsigned long long) number, ex->name_suffix.c_str());
+				FILE* fp = fopen(path, "wb");
+				failed = (fp == NULL);
+				if (fp != NULL) {
+					fprintf(fp, "P6\n%d %d\n255\n", w, h);
+					failed = fwrite(rgb.data(), 1, rgb.size(), fp) != rgb.size();
+					fclose(fp);
+				}
+			}
+			if (failed)
+				printf("Frame export to '%s' failed, no more frames will be written\n", ex->target);
+		}
+		number++;
+
+		if (idx >= 0) {
+			SDL_LockMutex(ex->lock);
+			ex->free_frames.push_back(idx);
+			SDL_UnlockMutex(ex->lock);
+		}
+	}
+	return 0;
+}
+
+
+/* Splits a numbered file target into what comes before and after its one "%d" or "%0Nd";
+ * returns 0 if it has anything else starting with '%' */
+int frame_export_pattern(frame_export_t* ex, const char* target)
+{
+	const char* pct = strchr(target, '%');
+	const char* p = pct + 1;
+	int digits = 0;
+
+	if (*p == '0') {
+		for (p++; *p >= '0' && *p <= '9' && digits < 100; p++)
+			digits = digits * 10 + (*p - '0');
+		if (digits == 0)
+			return 0;
+	}
+	if (*p != 'd' || strchr(p, '%') != NULL)
+		return 0;
+
+	ex->name_prefix.assign(target, pct - target);
+	ex->name_suffix.assign(p + 1);
+	ex->name_digits = digits;
+	return 1;
+}
+
+
+/* Starts exporting frames of width x height; see frame_export_t.target */
+int frame_export_open(frame_export_t* ex, const char* target, int width, int height)
+{
+	ex->target = target;
+	ex->out = NULL;
+	ex->piped = (target[0] == '|');
+	ex->width = width;
+	ex->height = height;
+
+	if (ex->piped) {
+	#ifdef _WIN32
+		ex->out = _popen(target + 1, "wb");
+	#else
+		signal(SIGPIPE, SIG_IGN); // a dead encoder shows up as a failed write instead
+		ex->out = popen(target + 1, "w");
+	#endif
+	} else if (strchr(target, '%') == NULL) {
+		ex->out = fopen(target, "wb");
+	} else if (!frame_export_pattern(ex, target)) {
+		printf("Frame export target '%s' needs exactly one %%d or %%0Nd and no other %%!\n", target);
+		return 1;
+	}
+	if (ex->out == NULL && (ex->piped || strchr(target, '%') == NULL)) {
+		printf("Could not open '%s' for frame export!\n", target);
+		return 1;
+	}
+
+	for (int i = 0; i < EXPORT_POOL_SIZE; i++) {
+		ex->frames[i].resize((size_t) width * height * 4);
+		ex->free_frames.push_back(i);
+	}
+	ex->lock = SDL_CreateMutex();
+	ex->cond = SDL_CreateCond();
+	ex->quit = 0;
+	ex->captured = 0;
+	ex->dropped = 0;
+	ex->thread = SDL_CreateThread(threaded_export, "export thread", (void*) ex);
+
+	printf("Exporting %dx%d RGB24 frames to '%s'\n", width, height, target);
+	return 0;
+}
+
+
+/*
+ *  Render thread: reads back the frame drawn but not yet presented into a
+ *  free buffer and queues it. The lock is only held to take and return a
+ *  buffer index; if the writer has fallen behind and none is free the frame
+ *  is dropped rather than making the renderer wait.
+ */
+void frame_export_capture(frame_export_t* ex, SDL_Renderer* renderer)
+{
+	SDL_LockMutex(ex->lock);
+	if (ex->free_frames.empty()) {
+		ex->dropped++;
+		SDL_UnlockMutex(ex->lock);
+		return;
+	}
+	int idx = ex->free_frames.back();
+	ex->free_frames.pop_back();
+	SDL_UnlockMutex(ex->lock);
+
+	if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, ex->frames[idx].data(), ex->width * 4) != 0) {
+		SDL_LockMutex(ex->lock);
+		ex->free_frames.push_back(idx);
+		ex->dropped++;
+		SDL_UnlockMutex(ex->lock);
+		return;
+	}
+
+	SDL_LockMutex(ex->lock);
+	ex->captured++;
+	ex->ready_frames.push_back(idx);
+	SDL_CondSignal(ex->cond);
+	SDL_UnlockMutex(ex->lock);
+}
+
+
+/* Render thread: the frame didn't change (or wasn't due), so the last one is written again
+ * and the export keeps one frame per period, in step with wall time */
+void frame_export_repeat(frame_export_t* ex)
+{
+	SDL_LockMutex(ex->lock);
+	if (ex->captured == 0 || ex->ready_frames.size() >= EXPORT_QUEUE_LIMIT) {
+		ex->dropped += (ex->captured != 0);
+		SDL_UnlockMutex(ex->lock);
+		return;
+	}
+	ex->captured++;
+	ex->ready_frames.push_back(-1);
+	SDL_CondSignal(ex->cond);
+	SDL_UnlockMutex(ex->lock);
+}
+
+
+/* Lets the writer drain what's queued, then closes the output */
+void frame_export_close(frame_export_t* ex)
+{
+	SDL_LockMutex(ex->lock);
+	ex->quit = 1;
+	SDL_CondSignal(ex->cond);
+	SDL_UnlockMutex(ex->lock);
+	SDL_WaitThread(ex->thread, NULL);
+
+	if (ex->out != NULL) {
+	#ifdef _WIN32
+		if (ex->piped) _pclose(ex->out); else fclose(ex->out);
+	#else
+		if (ex->piped) pclose(ex->out); else fclose(ex->out);
+	#endif
+	}
+	SDL_DestroyCond(ex->cond);
+	SDL_DestroyMutex(ex->lock);
+	printf("Exported %llu frames (%llu dropped)\n", (unsigned long long) ex->captured, (unsigned long long) ex->dropped);
+}
+
+
+/*
+ *  Windows are presented without vsync, back to back, and the whole set is
+ *  paced by one deadline advanced by a fixed period: a frame that ran late
+ *  shortens the next sleep instead of delaying every later frame, and if the
+ *  renderer falls more than a frame behind the deadline is reset rather than
+ *  rushing through the backlog. Graphs without new points are not redrawn at
+ *  all, and while none has any the thread sleeps on ctl->wakeup.
+ */
+int threaded_render(void* data)
+{
+	graph_control_t* ctl = (graph_control_t*) data;
+	std::vector<graph_t*>* graph_list = ctl->graph_list;
+	graph_dashboard_t* dashboard = ctl->dashboard;
+
+	const uint64_t freq = SDL_GetPerformanceFrequency();
+	const uint64_t period = freq / ctl->fps;
+	uint64_t deadline = SDL_GetPerformanceCounter() + period;
+	uint64_t next_report = SDL_GetTicks64() + RENDER_STATS_INTERVAL;
+	std::vector<graph_t*> changed;
 
 	while (g_running) {
-		startticks = SDL_GetTicks64();
-	
 		if (! g_render_paused) {
-			for (graph_t* gr : *graph_list) {
-				graph_render(gr);
+			if (dashboard != NULL) {
+				// Exports get a frame every period, the last one again if nothing was drawn
+				if (graph_dashboard_due(dashboard) && graph_dashboard_draw(dashboard, graph_list->data(), (int) graph_list->size())) {
+					if (ctl->exporter != NULL)
+						frame_export_capture(ctl->exporter, dashboard->window.renderer);
+					graph_dashboard_present(dashboard, graph_list->data(), (int) graph_list->size());
+				} else if (ctl->exporter != NULL) {
+					frame_export_repeat(ctl->exporter);
+				}
+			} else if (ctl->pool != NULL) {
+				changed.clear();
+				for (graph_t* gr : *graph_list) {
+					if (graph_changed(gr) && graph_due(gr))
+						changed.push_back(gr);
+				}
+				graph_raster_draw(ctl->pool, changed.data(), (int) changed.size());
+				for (graph_t* gr : changed)
+					graph_present(gr);
+			} else {
+				for (graph_t* gr : *graph_list) {
+					if (graph_changed(gr) && graph_due(gr))
+						graph_render(gr);
+				}
 			}
 		}
 
-		nowticks = SDL_GetTicks64();
-		if (nowticks - startticks < framedelay) {
-			SDL_Delay(framedelay - (nowticks-startticks));
+		if (ctl->stats && SDL_GetTicks64() >= next_report) {
+			next_report += RENDER_STATS_INTERVAL;
+			// Achieved/allowed per window, and what the refresh policies saved overall
+			float total = 0.0f;
+			int allowed = 0;
+			printf("fps (target %d):", ctl->fps);
+			for (size_t i = 0; i < ((dashboard != NULL) ? 1 : graph_list->size()); i++) {
+				Window* w = (dashboard != NULL) ? &dashboard->window : &graph_list->at(i)->window;
+				const int allows = SDL_AtomicGet(&w->refresh_fps);
+				const int limit = (allows < 0 || allows > ctl->fps) ? ctl->fps : allows;
+				const float fps = window_fps(w);
+				printf(" %.1f/%d", fps, limit);
+				total += fps;
+				allowed += limit;
+			}
+			printf(" | %.0f presents/s, at most %d of %d\n", total, allowed,
+				ctl->fps * ((dashboard != NULL) ? 1 : (int) graph_list->size()));
+		}
+
+		uint64_t now = SDL_GetPerformanceCounter();
+		if (now < deadline) {
+			SDL_Delay((uint32_t)((deadline - now) * 1000 / freq));
+			deadline += period;
+		} else if (now - deadline > period) {
+			deadline = now + period;
+		} else {
+			deadline += period;
+		}
+
+		// Idle until some graph that may be drawn changes; a writer bumps the generation before
+		// it posts, so nothing written after the check below can be missed (windows showing
+		// again get invalidated, which posts as well). Exports never idle, they need every period
+		uint8_t idle = !g_render_paused && ctl->exporter == NULL;
+		for (size_t i = 0; i < graph_list->size() && idle; i++) {
+			graph_t* gr = graph_list->at(i);
+			Window* w = (dashboard != NULL) ? &dashboard->window : &gr->window;
+			idle = !graph_changed(gr) || SDL_AtomicGet(&w->refresh_fps) == 0;
+		}
+
+		if (idle) {
+			SDL_SemWaitTimeout(ctl->wakeup, RENDER_IDLE_TIMEOUT);
+			deadline = SDL_GetPerformanceCounter();
 		}
 	}
 
@@ -180,12 +1146,6 @@ int main(int argc, char* argv[])
 	// because only the struct itself will be automatically freed with .consume
 */
 
-	int err;
-	if ((err = graph_load()) != 0) {
-		printf("SDL load error! (%d)\n", err);
-		return err;
-	}
-
 	// FILE* fp;
 	// if ((fp = fopen("cfg.json", "r")) == NULL) {
 	// 	printf("ERROR OPENING JSON FILE");
@@ -206,29 +1166,174 @@ int main(int argc, char* argv[])
 	// 	fclose(fp);
 	// }
 
+	std::vector<graph_t*>	graph_list;
+	graph_control_t ctl = {&graph_list};
+	ctl.fps = RENDER_DEFAULT_FPS;
+	ctl.wakeup = SDL_CreateSemaphore(0);
+
 	// Pickup graph params from cmd
+	//   graphing [ngraphs] [--binary] [--udp [addr:]port] [--shm name] [--file path] [--n points] [--dashboard]
+	//            [--fps target] [--stats] [--scroll] [--headless] [--export target] [--raster [threads]]
+	//            [--refresh focused,unfocused,hidden] [--series k] [--step] [--fill] [--line-width px]
+	//            [--window-stats]
 	int ngraphs = 1;
-	if (argc > 1) {
-		ngraphs = atoi(argv[1]);
-		if (ngraphs < 1) {
-			printf("Cannot create < 1 windows >:( , defaulting to 1!\n");
-			ngraphs = 1;
+	int graph_n = 0;
+	uint8_t dashboard = 0;
+	uint8_t scroll = 0;
+	uint8_t headless = 0;
+	const char* export_target = NULL;
+	int raster = -1;
+	int series = 1;
+	uint8_t style = GRAPHING_STYLE_LINE;
+	uint8_t fill = 0;
+	float line_width = 1.0f;
+	uint8_t window_stats = 0;
+	graph_refresh_t refresh = GRAPHING_DEFAULT_REFRESH;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--binary") == 0) {
+			ctl.binary = 1;
+
+		} else if (strcmp(argv[i], "--dashboard") == 0) {
+			dashboard = 1;
+
+		} else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			ctl.fps = atoi(argv[++i]);
+			if (ctl.fps < 1)
+				ctl.fps = RENDER_DEFAULT_FPS;
+
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			ctl.stats = 1;
+
+		} else if (strcmp(argv[i], "--scroll") == 0) {
+			scroll = 1;
+
+		} else if (strcmp(argv[i], "--headless") == 0) {
+			headless = 1;
+
+		} else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+			export_target = argv[++i];
+			dashboard = 1; // frames are read back from the one dashboard window
+
+		} else if (strcmp(argv[i], "--raster") == 0) {
+			raster = (i + 1 < argc && argv[i+1][0] != '-') ? atoi(argv[++i]) : 0;
+
+		} else if (strcmp(argv[i], "--refresh") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%d,%d,%d", &refresh.focused, &refresh.unfocused, &refresh.hidden) != 3)
+				printf("--refresh expects focused,unfocused,hidden frame rates (e.g. -1,15,0), ignoring\n");
+
+		} else if (strcmp(argv[i], "--series") == 0 && i + 1 < argc) {
+			series = atoi(argv[++i]);
+			if (series < 1 || series > GRAPHING_MAX_SERIES)
+				series = 1;
+
+		} else if (strcmp(argv[i], "--step") == 0) {
+			style = GRAPHING_STYLE_STEP;
+
+		} else if (strcmp(argv[i], "--fill") == 0) {
+			fill = 1;
+
+		} else if (strcmp(argv[i], "--line-width") == 0 && i + 1 < argc) {
+			line_width = (float) atof(argv[++i]);
+			if (line_width <= 0.0f)
+				line_width = 1.0f;
+
+		} else if (strcmp(argv[i], "--window-stats") == 0) {
+			window_stats = 1;
+
+		} else if (strcmp(argv[i], "--udp") == 0) {
+			ctl.udp = (i + 1 < argc && argv[i+1][0] != '-') ? argv[++i] : "";
+
+		} else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+			ctl.shm = argv[++i];
+
+		} else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+			ctl.file = argv[++i];
+
+		} else if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) {
+			graph_n = atoi(argv[++i]);
+
+		} else if (argv[i][0] != '-') {
+			ngraphs = atoi(argv[i]);
+			if (ngraphs < 1) {
+				printf("Cannot create < 1 windows >:( , defaulting to 1!\n");
+				ngraphs = 1;
+			}
+
+		} else {
+			printf("Unknown option '%s', ignoring\n", argv[i]);
 		}
 	}
 
-	std::vector<graph_t*>	graph_list;
-	graph_control_t ctl = {&graph_list};
+	// With --series every graph plots that many consecutive channels
+	const int nwindows = (ngraphs + series - 1) / series;
+
+	int err;
+	if ((err = (headless ? graph_load_headless() : graph_load())) != 0) {
+		printf("SDL load error! (%d)\n", err);
+		return err;
+	}
+
 	// SDL_mutex* mainmutex = SDL_CreateMutex();
 	// graph_control_t ctl = {&graph_list, mainmutex};
 
+	// Dataset gets indexed first, by default every one of its rows is shown
+	dataset_t ds;
+	if (ctl.file != NULL) {
+		if (dataset_map(&ds, ctl.file) != 0) {
+			printf("Could not open dataset '%s'!\n", ctl.file);
+			graph_shutdown();
+			return 1;
+		}
+		ds.binary = ctl.binary || (ds.size >= 4 && memcmp(ds.data, GRAPHING_FRAME_MAGIC, 4) == 0);
+		dataset_index(&ds, ngraphs);
+		printf("Dataset '%s': %llu rows\n", ctl.file, (unsigned long long) ds.nrows);
+
+		if (graph_n < 1)
+			graph_n = (ds.nrows < INT_MAX) ? (int) ds.nrows : INT_MAX;
+	}
+
 	SDL_DisplayMode scr;
-	SDL_GetCurrentDisplayMode(0, &scr);
+	if (SDL_GetCurrentDisplayMode(0, &scr) != 0) {
+		scr.w = INT_MAX; // headless, nothing to wrap around
+		scr.h = INT_MAX;
+	}
 	int ychunk = HEIGHT; // scr.h
 	int xchunk = WIDTH; // scr.w
 	int title_offset = 26;
+
+	// One window for everything, laid out N_GRAPHS_IN_COLUMN per column as long as that fits
+	if (dashboard) {
+		ctl.dashboard = graph_dashboard_create("graphing", nwindows, WIDTH, HEIGHT, N_GRAPHS_IN_COLUMN);
+		if (ctl.dashboard == NULL) {
+			graph_shutdown();
+			return 1;
+		}
+	}
+
+	if (ctl.dashboard != NULL) {
+		ctl.dashboard->window.refresh = refresh;
+		window_set_state_(&ctl.dashboard->window, (uint8_t) SDL_AtomicGet(&ctl.dashboard->window.state));
+	}
+
+	// Rasterize on the CPU, threads + 1 at a time (the render thread joins in)
+	if (raster >= 0) {
+		ctl.pool = graph_pool_create(raster);
+		if (ctl.dashboard != NULL)
+			ctl.dashboard->pool = ctl.pool;
+	}
+
+	frame_export_t exporter;
+	if (export_target != NULL) {
+		if (frame_export_open(&exporter, export_target, ctl.dashboard->window.width, ctl.dashboard->window.height) != 0) {
+			graph_dashboard_destroy(ctl.dashboard);
+			graph_shutdown();
+			return 1;
+		}
+		ctl.exporter = &exporter;
+	}
 	
 	char titlebuff[32+1];
-	for (int i = 0; i < ngraphs; i++) {
+	for (int i = 0; i < nwindows; i++) {
 		graph_setup_t* setup = graph_blank_setup();
 
 		// Set window title
@@ -236,10 +1341,27 @@ int main(int argc, char* argv[])
 		setup->title = titlebuff;
 		setup->width = WIDTH;
 		setup->height = HEIGHT;
+		if (graph_n > 0)
+			setup->graph_n = graph_n;
 
 		// Calc and set x and y on screen where window is places
-		setup->xpos = (((i / N_GRAPHS_IN_COLUMN) * xchunk)) % scr.w;
-		setup->ypos = (((i % N_GRAPHS_IN_COLUMN) * (ychunk + title_offset)) + title_offset) % scr.h;
+		if (ctl.dashboard != NULL) {
+			graph_dashboard_place(ctl.dashboard, i, setup);
+		} else {
+			setup->xpos = (((i / N_GRAPHS_IN_COLUMN) * xchunk)) % scr.w;
+			setup->ypos = (((i % N_GRAPHS_IN_COLUMN) * (ychunk + title_offset)) + title_offset) % scr.h;
+		}
+		setup->mipmap = (setup->graph_n > 8 * setup->width);
+		setup->vsync = 0; // the render thread paces all windows itself
+		setup->notify = ctl.wakeup;
+		setup->scroll = scroll;
+		setup->show_value = 1;
+		setup->show_stats = window_stats;
+		setup->refresh = refresh;
+		setup->style = style;
+		setup->fill = fill;
+		setup->line_width = line_width;
+		setup->series = (ngraphs - i * series < series) ? ngraphs - i * series : series;
 
 		// Lets change up some colors dunno
 		if (i % 2)
@@ -251,11 +1373,47 @@ int main(int argc, char* argv[])
 		graph_list.push_back(gr);
 	}
 
-	SDL_Thread* thr_inp = SDL_CreateThread(threaded_input, "input thread", (void*) &ctl);
-	SDL_Thread* thr_ren = SDL_CreateThread(threaded_render, "render thread", (void*) &graph_list);
+	if (ctl.file != NULL) {
+		dataset_fill(&ds, &graph_list);
+		dataset_unmap(&ds);
+	}
+
+	SDL_ThreadFunction input_fn = threaded_input;
+	uint8_t join_input = 0; // UDP and shared memory threads poll g_running, so they can be waited for
+	if (ctl.udp != NULL || ctl.shm != NULL) {
+	#ifdef __linux__
+		input_fn = (ctl.shm != NULL) ? threaded_shm : threaded_udp;
+		join_input = 1;
+	#else
+		printf("UDP/shared memory input is only supported on Linux, reading stdin instead\n");
+	#endif
+	}
+
+	SDL_Thread* thr_inp = NULL;
+	if (ctl.file == NULL)
+		thr_inp = SDL_CreateThread(input_fn, "input thread", (void*) &ctl);
+	else
+		g_input_thread_done = 1;
+	SDL_Thread* thr_ren = SDL_CreateThread(threaded_render, "render thread", (void*) &ctl);
 
 	//// (Main loop)
 	SDL_Event e;
+
+	// Nobody is watching: run until the input ends (or SIGINT), then until the last points are drawn
+	if (headless) {
+		while (g_running && !g_input_thread_done) {
+			if (SDL_WaitEventTimeout(&e, 100) && e.type == SDL_QUIT)
+				g_running = 0;
+		}
+		for (size_t i = 0; g_running && i < graph_list.size(); ) {
+			if (graph_changed(graph_list[i]))
+				SDL_Delay(1);
+			else
+				i++;
+		}
+		g_running = 0;
+	}
+
 	while (g_running) {
 		while (SDL_WaitEvent(&e) != 0) {
 			switch(e.type) {
@@ -278,10 +1436,23 @@ int main(int argc, char* argv[])
 					}
 					break;
 
+				// Target textures lost their contents (e.g. Direct3D device reset)
+				case SDL_RENDER_TARGETS_RESET:
+				case SDL_RENDER_DEVICE_RESET:
+					for (graph_t* gr : graph_list)
+						graph_invalidate(gr);
+					break;
+
 				case SDL_WINDOWEVENT:
 					if (!g_running)
 						break;
 
+					// Refresh policies follow minimizing, hiding and focus
+					if (ctl.dashboard != NULL)
+						graph_dashboard_handle_event(ctl.dashboard, graph_list.data(), (int) graph_list.size(), &e);
+					for (graph_t* gr : graph_list)
+						graph_handle_event(gr, &e);
+
 					switch (e.window.event) {
 
 						// User click on X button
@@ -289,9 +1460,12 @@ int main(int argc, char* argv[])
 							mainloop_quit();
 							break;
 
+						// The others' events get flushed, so their state is set here
 						case SDL_WINDOWEVENT_MINIMIZED:
 							for (graph_t* gr : graph_list) {
 								SDL_MinimizeWindow(gr->window.window);
+								if (gr->owns_window)
+									window_set_state_(&gr->window, GRAPHING_WINDOW_HIDDEN);
 							}
 							SDL_FlushEvent(SDL_WINDOWEVENT);
 							break;
@@ -299,10 +1473,23 @@ int main(int argc, char* argv[])
 						case SDL_WINDOWEVENT_RESTORED:
 							for (graph_t* gr : graph_list) {
 								SDL_RestoreWindow(gr->window.window);
+								if (gr->owns_window && SDL_AtomicGet(&gr->window.state) == GRAPHING_WINDOW_HIDDEN)
+									window_set_state_(&gr->window, GRAPHING_WINDOW_UNFOCUSED);
+								graph_invalidate(gr);
 							}
 							SDL_FlushEvent(SDL_WINDOWEVENT);
 							break;
 
+						// Window contents need redrawing even if no new points came in
+						case SDL_WINDOWEVENT_EXPOSED: {
+							SDL_Window* exposed = SDL_GetWindowFromID(e.window.windowID);
+							for (graph_t* gr : graph_list) {
+								if (gr->window.window == exposed)
+									graph_invalidate(gr);
+							}
+							break;
+						}
+
 					#ifndef GRAPHING_NO_AUTO_WIN_UPDATES
 
 						case SDL_WINDOWEVENT_FOCUS_GAINED:
@@ -367,11 +1554,21 @@ int main(int argc, char* argv[])
 	// SDL_DestroyMutex(mainmutex);
 	// #endif
 
-	// SDL_WaitThread(thr_inp, NULL);
 	// SDL_WaitThread(thr_ren, NULL);
 
+	// The stdin reader may sit in getline forever, but the UDP and shared memory threads keep
+	// appending to the graphs (and the latter holds its mapping) until they see g_running
+	if (join_input && thr_inp != NULL)
+		SDL_WaitThread(thr_inp, NULL);
+
+	if (ctl.exporter != NULL)
+		frame_export_close(ctl.exporter);
+
 	for (graph_t* gr : graph_list)
 		graph_destroy(gr);
+	graph_dashboard_destroy(ctl.dashboard);
+	graph_pool_destroy(ctl.pool);
+	SDL_DestroySemaphore(ctl.wakeup);
 
 	graph_shutdown();
 	printf("Exited gracefully.\n");	
@@ -6,7 +6,9 @@
  *	#define GRAPHING_NO_CACHING
  *	- by default uses uthash.h library to cache legend textures and fonts
  *	#define GRAPHING_USE_MUTEX
- *	- use a mutex when adding/appending new points to a graph (default: no)
+ *	- use a mutex when adding/appending new points to a graph (default: no);
+ *	  only needed if several threads append to the same graph, rendering
+ *	  never takes it either way
  *	#define GRAPHING_USE_SYSTEM_SDL
  *	- by default includes SDL from src/SDL2/
  *	- define this to use #include <SDL2/SDL.h> instead of #include "SDL2/SDL.h"
@@ -14,6 +16,9 @@
  *	- do not initialize srand(); assumes you will do so manually elsewhere
  *	#define GRAPHING_NO_DEFINED_COLORS
  *	- do not define common constants such as BLACK, WHITE, RED... (default: it does.)
+ *	#define GRAPHING_NO_SIMD
+ *	- transform points to screen coordinates with plain loops only (default: SSE2,
+ *	  and AVX2 if the CPU has it, on x86/x64)
  * 
  */
 
@@ -52,6 +57,16 @@ extern "C" {
 	#include "tdh/uthash.h"
 #endif
 
+#if !defined(GRAPHING_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define GRAPHING_SIMD
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define GRAPHING_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define GRAPHING_TARGET_AVX2
+	#endif
+#endif
+
 #ifndef ARR_SIZE
 #define ARR_SIZE(arr) (sizeof(arr)/sizeof(arr[0]))
 #endif
@@ -106,6 +121,11 @@ const char GRAPHING_DEFAULT_FONT[]          = "selawk.ttf";
 #define GRAPHING_DEFAULT_BG_ALPHA           0xFF
 #define GRAPHING_DEFAULT_FG_ALPHA           0x00
 #define GRAPHING_DEFAULT_PLOT_ALPHA         0xFF
+#define GRAPHING_DEFAULT_FILL_ALPHA         0x50
+
+// How points are connected (setup->style)
+#define GRAPHING_STYLE_LINE                 0   // straight from point to point
+#define GRAPHING_STYLE_STEP                 1   // each value held until the next point
 
 #define GRAPHING_DEFAULT_TITLE_SIZE         32+1
 
@@ -119,14 +139,55 @@ const char GRAPHING_DEFAULT_FONT[]          = "selawk.ttf";
 #define GRAPHING_DEFAULT_YMARGIN            10
 #define GRAPHING_DEFAULT__EXTENDED_YMARGIN  20
 
+#define GRAPHING_MAX_MIP_LEVELS             32
+#define GRAPHING_MAX_SERIES                 16
+#define GRAPHING_DASHBOARD_MIN_TILE         16  // px, graph_dashboard_create fails rather than go smaller
+
+#ifndef GRAPHING_SIMD_MIN_POINTS
+#define GRAPHING_SIMD_MIN_POINTS            1024  // shorter spans go through the plain loop (see examples/bench_transform.c)
+#endif
+
+#ifndef GRAPHING_TILE_BYTES
+#define GRAPHING_TILE_BYTES                 16384 // source rows transposed at a time by graph_appendrows
+#endif
+
+// Window states a refresh policy distinguishes
+#define GRAPHING_WINDOW_FOCUSED             0
+#define GRAPHING_WINDOW_UNFOCUSED           1
+#define GRAPHING_WINDOW_HIDDEN              2   // minimized or hidden, nothing of it is visible
+
+#define GRAPHING_DEFAULT_REFRESH            {-1, 15, 0}
+
+// Frame rates a window gets drawn at in each state: < 0 as often as the render loop
+// goes, 0 not at all (see graph_due)
 typedef struct {
-	SDL_Window* window;
+	int focused;
+	int unfocused;
+	int hidden;
+} graph_refresh_t;
+
+typedef struct {
+	SDL_Window* window;        // NULL when headless
 	SDL_Renderer* renderer;
+	SDL_Surface* surface;      // headless only: what the software renderer draws into
 
 	char* title;
 	int width;
 	int height;
 	int fps;
+
+	float achieved_fps;        // presents per second, updated about once a second
+	uint32_t _frames;
+	uint64_t _fps_since;
+
+	// State changes come from the event thread while the render thread checks them, so both
+	// go through atomics; _next_frame belongs to the render thread alone and is only told
+	// to start over through _reschedule
+	graph_refresh_t refresh;   // policy, applied by window_set_state_()
+	SDL_atomic_t state;        // GRAPHING_WINDOW_*, kept up to date by graph_handle_event()
+	SDL_atomic_t refresh_fps;  // rate the policy allows in the current state
+	SDL_atomic_t _reschedule;  // set by window_set_state_(), _next_frame is reset on the next check
+	uint64_t _next_frame;      // performance counter before which the window isn't due again
 } Window;
 
 typedef struct {
@@ -134,8 +195,100 @@ typedef struct {
 	SDL_Texture* texture;
 } textpos_t;
 
+#define GRAPHING_ATLAS_FIRST                32  // ' '
+#define GRAPHING_ATLAS_LAST                 126 // '~', anything outside is drawn as '?'
+#define GRAPHING_ATLAS_COLUMNS              16
+
+// Printable ASCII of one font rendered once in white into one texture of one renderer;
+// text is then drawn as textured quads, colored per vertex
+typedef struct {
+	SDL_Renderer* renderer;
+	TTF_Font* font;
+	SDL_Texture* texture;
+	int height;
+	SDL_Rect glyphs[GRAPHING_ATLAS_LAST - GRAPHING_ATLAS_FIRST + 1]; // in the texture
+	int advance[GRAPHING_ATLAS_LAST - GRAPHING_ATLAS_FIRST + 1];
+
+	SDL_Vertex* verts;         // geometry of the string being drawn
+	int* indices;
+	int capacity;              // in glyphs
+} graph_atlas_t;
+
+// What a graph's cached background was built for
+typedef struct {
+	SDL_Color fg_color;
+	SDL_Color bg_color;
+	int width;
+	int height;
+} graph_background_key_t;
+
+// Summary of the points currently in one series' window (see graph_stats)
+typedef struct {
+	float min;
+	float max;
+	double mean;
+	double stddev;             // population standard deviation
+	int count;                 // points appended so far, at most graph_n
+} graph_stats_t;
+
+// Sliding-window state of one series, only touched by the writer. The deques hold indices
+// into the series' points, oldest first, whose values only increase (min) or decrease (max)
+// from front to back, so the front is always the extreme; a point falls out of the window
+// exactly when its index gets written again. The sums are of (value - shift) and get
+// recomputed from the points every graph_n steps, shift being the mean at that time.
+typedef struct {
+	int* minq;
+	int* maxq;
+	int min_front, min_len;
+	int max_front, max_len;
+	int count;
+	double shift;
+	double sum;
+	double sumsq;
+	int since_exact;
+} graph_stats_state_t;
+
+// Range of task indices a pool thread works through from the front; idle threads steal from the back
+typedef struct {
+	SDL_SpinLock lock;
+	int begin;
+	int end;
+} graph_pool_queue_t;
+
+// Worker threads running batches of independent tasks (e.g. rasterizing graphs) with work stealing;
+// the thread that submits a batch works on it too
+typedef struct {
+	int nthreads;              // workers, not counting the submitting thread
+	SDL_Thread** threads;
+	graph_pool_queue_t* queues; // nthreads + 1, the last one is the submitting thread's
+	SDL_sem* start;            // posted once per worker for every batch
+	SDL_sem* done;             // posted by whoever finishes the last task of a batch
+	SDL_atomic_t remaining;
+	SDL_atomic_t started;      // workers hand out their queue indices with it
+	void (*task)(void* ctx, int i);
+	void* ctx;
+	volatile uint8_t quit;
+
+	void** batch;              // scratch for whoever submits batches
+	int batch_capacity;
+} graph_pool_t;
+
+// One window holding many graphs as tiles, drawn with one renderer and presented once per frame
+typedef struct {
+	Window window;
+	graph_pool_t* pool;        // if set, tiles are rasterized on the CPU by the pool (see graph_raster_draw)
+
+	int tile_width;
+	int tile_height;
+	int rows;                  // tiles per column; tiles fill columns top to bottom, left to right
+	int columns;
+	float scale;               // < 1 if tiles had to shrink to fit on the display
+} graph_dashboard_t;
+
 typedef struct {
 	Window window;
+	SDL_Rect viewport;         // where in the window the graph is drawn
+	uint8_t owns_window;       // 0 for dashboard tiles, which share the dashboard's window
 
 	int graph_amp;
 	int graph_n;
@@ -152,6 +305,7 @@ typedef struct {
 
 	int zerox;
 	int zeroy;
+	float yscale;              // pixels per unit of y
 	int real_ysize;
 	int real_xsize;
 	int ysegment_size;
@@ -167,9 +321,83 @@ typedef struct {
 	int ysegment_count;
 	textpos_t* ysegment_texts;
 
-	int pos;
-	float* points_f;
-	SDL_FPoint* _render_points_f;
+	int pos;                   // next index to append at; only touched by the writer
+	float* points_f;           // series k at points_f[k * graph_n], all sharing pos/claim/head
+	SDL_FPoint* _render_points_f; // likewise graph_n per series
+
+	// Series drawn on the same axes; series 0 is plot_color and the one graph_appendpoint(s),
+	// graph_addpoint(s), the pyramid and the value text work on
+	int series;
+	SDL_Color series_color[GRAPHING_MAX_SERIES];
+
+	uint8_t style;             // GRAPHING_STYLE_*
+	uint8_t fill;              // area between the curve and the zero line, translucent
+	float line_width;
+
+	// Triangles of all series built per frame and submitted with one SDL_RenderGeometry
+	SDL_Vertex* _geom_verts;
+	int* _geom_indices;
+	int _geom_nverts;
+	int _geom_nindices;
+	int _geom_capacity;        // in quads
+
+	// Single-writer ring: the writer bumps `claim` before it touches any points
+	// and `head` after they're all written; both count appended points modulo
+	// `seq_wrap` (a multiple of graph_n), so head % graph_n is the oldest point.
+	SDL_atomic_t claim;
+	SDL_atomic_t head;
+	int seq_wrap;
+
+	// Optional min/max pyramid (setup->mipmap): level k keeps a (min, max) pair
+	// for every 2^k consecutive points, mip_count[k-1] = ceil(graph_n / 2^k) of them
+	int mip_levels;
+	int mip_count[GRAPHING_MAX_MIP_LEVELS];
+	float* mip[GRAPHING_MAX_MIP_LEVELS];
+
+	// Reduced vertices (pyramid buckets or per-column envelope), at most 4 per pixel column,
+	// _env_stride apart per series; only allocated when graph_n exceeds the plot width
+	SDL_FPoint* _render_env_f;
+	int _env_stride;
+
+	// Bumped by every write (and graph_invalidate), so the renderer can skip graphs
+	// that look the same as when it last drew them; `notify` is posted on bumps
+	SDL_atomic_t generation;
+	int _drawn_generation;
+	SDL_sem* notify;
+
+	uint8_t show_value;        // print the newest value in the top right corner every frame
+	uint8_t show_stats;        // print series 0's window statistics in the top left corner, below the value
+
+	// Sliding-window statistics (setup->stats), NULL if off: the writer keeps _stats up to date
+	// point by point and copies the summaries into _stats_out once per call, bumping
+	// _stats_version before and after so readers can tell a torn copy (see graph_stats)
+	graph_stats_state_t* _stats; // one per series
+	graph_stats_t* _stats_out;
+	SDL_atomic_t _stats_version;
+
+	// Background, grid, axes and labels drawn once into a texture and copied every frame;
+	// rebuilt if the colors or size no longer match _background_key, or after a reset
+	SDL_Texture* _background;
+	graph_background_key_t _background_key;
+	volatile uint8_t _background_reset;
+	int _background_builds;    // times _background was (re)drawn
+
+	// CPU rasterization (graph_raster_draw): a pool thread draws the plot over a copy of the
+	// background read back into memory, the render thread only uploads it into _raster_tex
+	uint32_t* _raster_pixels;  // ARGB8888, window.width * window.height
+	uint32_t* _raster_background;
+	int _raster_builds;        // _background_builds the background copy was read at
+	SDL_Texture* _raster_tex;
+	uint8_t _raster_drawn;     // _raster_pixels hold a frame not uploaded yet
+
+	// Scrolling mode (setup->scroll): the polyline lives in one of two target textures;
+	// each frame the other one gets it shifted left by whole pixels plus the new segments
+	SDL_Texture* _scroll_tex[2];
+	int _scroll_cur;
+	int _scroll_head;          // head when the texture was last brought up to date
+	long long _scroll_total;   // points appended up to _scroll_head
+	long long _scroll_off;     // texture x = xscale * point number - _scroll_off
+	volatile uint8_t _scroll_reset; // texture needs a full redraw
 
 	#ifdef GRAPHING_USE_MUTEX
 	SDL_mutex* mutex; //
@@ -186,6 +414,8 @@ typedef struct
 	char* title;
 	int width, height;
 	int xpos, ypos;    // where on screen to place the newly created window
+	graph_dashboard_t* dashboard; // if set, no window is created: the graph is a tile at
+	                              //   (xpos, ypos) in the dashboard (see graph_dashboard_place)
 
 	// Graph settings
 	int graph_amp;     // max y value that will be represented
@@ -205,6 +435,52 @@ typedef struct
 	SDL_Color bg_color;
 	SDL_Color plot_color;
 
+	// Print the newest value in the top right corner every frame (default=no)
+	uint8_t show_value;
+
+	// Keep min, max, mean and standard deviation of the last graph_n points of every series
+	// up to date on every append, O(1) amortized per point (default=no, costs 8 bytes per
+	// point and series); show_stats also prints series 0's in the top left corner every
+	// frame, on the line below show_value's, and turns them on
+	uint8_t stats;
+	uint8_t show_stats;
+
+	// Series sharing the graph's axes, filled by graph_appendseries() or graph_appendrows()
+	// (default=1, at most GRAPHING_MAX_SERIES); colors of series 1 onwards, NULL for the
+	// default palette (series 0 is always plot_color). Pyramid and scrolling are single
+	// series only and get turned off for more
+	int series;
+	const SDL_Color* series_colors;
+
+	// Plot style: GRAPHING_STYLE_LINE or GRAPHING_STYLE_STEP (default=line), the area
+	// under the curve filled (default=no) and the line width in pixels (default=1); any
+	// of these draw through one batch of triangles instead of 1 px lines
+	uint8_t style;
+	uint8_t fill;
+	float line_width;
+
+	// Keep the plot in a texture that is shifted left every frame, so only the points
+	// appended since the last frame get drawn (default=no; falls back to full redraws
+	// if the renderer can't render to textures)
+	uint8_t scroll;
+
+	// Semaphore posted whenever the graph gets new points, so a render thread with nothing
+	// to draw can sleep on it (default=none)
+	SDL_sem* notify;
+
+	// Frame rates the window is drawn at while focused, unfocused and minimized or hidden,
+	// by render loops checking graph_due() (default={-1, 15, 0}: as often as the loop goes,
+	// 15 fps, not at all)
+	graph_refresh_t refresh;
+
+	// Wait for vblank on every present (default=yes); turn off when one thread presents
+	// many windows, otherwise each of them waits and the refresh rate drops to 60/N Hz
+	uint8_t vsync;
+
+	// Keep a min/max pyramid of the points so graphs with graph_n far beyond their
+	// width in pixels draw about as fast as small ones (default=no, costs 2x memory)
+	uint8_t mipmap;
+
 	// Control whether this struct gets freed after 1 use (default=yes)
 	uint8_t consume;
 
@@ -243,20 +519,89 @@ typedef struct
 #endif
 
 
+// Set by graph_load_headless(): windows are created as software-rendered surfaces
+uint8_t g_graphing_headless = 0;
+
+// Colors of series 1 onwards unless the setup says otherwise
+const SDL_Color g_graphing_palette[] = {
+	{0x00, 0x70, 0xD0, 0xFF}, {0xE0, 0x70, 0x00, 0xFF}, {0x00, 0xA0, 0x40, 0xFF}, {0xD0, 0x20, 0x20, 0xFF},
+	{0x60, 0x60, 0x60, 0xFF}, {0x90, 0x60, 0x00, 0xFF}, {0x00, 0xA0, 0xA0, 0xFF}, {0x80, 0x40, 0xC0, 0xFF},
+};
+
+// Glyph atlases of every (renderer, font) pair text was drawn with
+graph_atlas_t** g_glyph_atlases = NULL;
+int g_glyph_atlas_count = 0;
+
+
 // Public
 int graph_load();                                                 // Inits SDL+TTF (also sets SDL hint SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH); call
                                                                   //   once at the start of the program or none if you're doing it manually
+int graph_load_headless();                                        // Same as graph_load but without video: every "window" is an in-memory
+                                                                  //   surface drawn by the software renderer, no display needed
 
 void graph_shutdown();                                            // Destroys SDL+TFF (also deallocates caches)
 
 graph_t* graph_create(graph_setup_t* setup);                      // Allocates a new graph on a new window
 void graph_destroy(graph_t* graph);                               // Cleans up graph and closes its window
 void graph_render(graph_t* graph);                                // Call in a loop to redraw points
+void graph_draw(graph_t* graph);                                  // Same as graph_render but without presenting the window
+uint8_t graph_changed(graph_t* graph);                            // Whether the graph got written to since it was last drawn
+void graph_invalidate(graph_t* graph);                            // Marks the graph as changed and to be redrawn in full
+                                                                  //   (e.g. its window was exposed or render targets were lost)
+SDL_Surface* graph_surface(graph_t* graph);                       // Headless: surface holding the graph's last render (NULL otherwise)
+int graph_text(SDL_Renderer* renderer, TTF_Font* font,            // Draws ASCII text with one batched geometry call through a glyph
+                      const char* text, float x, float y,         //   atlas (built on first use per renderer and font); returns the
+                      SDL_Color color);                           //   width in pixels. Cheap enough for text that changes every frame
+int graph_text_width(SDL_Renderer* renderer, TTF_Font* font,      // Width graph_text would draw text with
+                      const char* text);
 void graph_addpoint(graph_t* graph, int x, float y);              // Set point at a specific x position
+void graph_addpoints(graph_t* graph, int x, const float* ys, int n); // Set n points starting at x (wraps around past graph_n)
 void graph_appendpoint(graph_t* graph, float y);                  // Append point to the end of the current list
+void graph_appendpoints(graph_t* graph, const float* ys, int n);  // Append n points at once (one lock, at most two memcpys)
+void graph_appendrows(graph_t** graphs, int ngraphs,              // Append nrows rows (each `stride` floats apart); each graph takes as
+                      const float* rows, int nrows, int stride);  //   many consecutive values of every row as it has series (one with a
+                                                                  //   single series); each graph is locked once per call
+void graph_appendseries(graph_t* graph, const float* rows,        // Append nrows rows of graph->series values, one per series
+                      int nrows);
+uint8_t graph_stats(graph_t* graph, int series,                  // Copies min/max/mean/stddev of the series' last graph_n points
+                      graph_stats_t* out);                        //   as of the last append; 0 if the graph keeps no stats
 
 graph_setup_t* graph_blank_setup();                               // Allocates a setup struct filled with default values
 
+graph_dashboard_t* graph_dashboard_create(const char* title,      // Opens one window for ngraphs tiles, `rows` per column if they
+                      int ngraphs, int tile_width,                //   fit on the display, otherwise the grid (and tiles) that fit best
+                      int tile_height, int rows);                 //   (NULL if they'd shrink below GRAPHING_DASHBOARD_MIN_TILE px)
+void graph_dashboard_place(graph_dashboard_t* dash, int i,        // Makes the setup create tile i of the dashboard
+                      graph_setup_t* setup);
+int graph_dashboard_render(graph_dashboard_t* dash,               // Draws all tiles and presents the window once if any of
+                      graph_t** graphs, int ngraphs);             //   them changed; returns whether it did
+int graph_dashboard_draw(graph_dashboard_t* dash,                 // Same as graph_dashboard_render but without presenting, so the
+                      graph_t** graphs, int ngraphs);             //   frame can still be read back (SDL_RenderReadPixels)
+void graph_dashboard_present(graph_dashboard_t* dash,             // Presents what graph_dashboard_draw drew
+                      graph_t** graphs, int ngraphs);
+void graph_dashboard_destroy(graph_dashboard_t* dash);            // Closes the window; destroy its graphs first
+
+graph_pool_t* graph_pool_create(int nthreads);                    // Starts nthreads workers (<= 0: one less than there are cores)
+void graph_pool_run(graph_pool_t* pool, int ntasks,               // Runs task(ctx, i) for every i < ntasks on the workers and the
+                      void (*task)(void* ctx, int i), void* ctx); //   calling thread, idle ones stealing from busy ones; returns when done
+void graph_pool_destroy(graph_pool_t* pool);                      // Stops and joins the workers
+int graph_raster_draw(graph_pool_t* pool, graph_t** graphs,       // Same as graph_draw for every graph, except the changed ones are
+                      int ngraphs);                               //   rasterized into memory by the pool in parallel and only uploaded
+                                                                  //   with SDL_UpdateTexture by the calling (render) thread; returns how
+                                                                  //   many were rasterized
+void graph_present(graph_t* graph);                               // Presents the graph's own window (what graph_draw or graph_raster_draw drew)
+
+void graph_handle_event(graph_t* graph, const SDL_Event* e);      // Tracks whether the graph's window is focused, unfocused or hidden
+                                                                  //   (pass it every window event); invalidates it once it shows again
+uint8_t graph_due(graph_t* graph);                                // Whether the refresh policy lets the window be drawn now; render loops
+                                                                  //   skip graphs that aren't (tiles answer for the dashboard's window)
+void graph_dashboard_handle_event(graph_dashboard_t* dash,        // Same as graph_handle_event for the dashboard's window
+                      graph_t** graphs, int ngraphs, const SDL_Event* e);
+uint8_t graph_dashboard_due(graph_dashboard_t* dash);             // Same as graph_due for the dashboard's window
+float window_fps(Window* w);                                      // Presents per second since the previous update (at least a second ago),
+                                                                  //   so unlike achieved_fps it drops while nothing gets presented;
+                                                                  //   compare with w->refresh_fps (atomic), the rate the policy currently allows
+
 // Deprecated
 uint32_t graph_finish_setup(graph_setup_t* setup, uint8_t need);  // Fills missing fields with default values; 'need' is a bitmask of the fields 
                                                                   //   that need to be filled with default values but cannot be detected (only some
@@ -272,9 +617,59 @@ TTF_Font* graph_open_font_(const char* fpath, int fsize, uint8_t fallback_to_def
 TTF_Font* graph_open_font(const char* fpath, int fsize);
 
 void graph_init_render_(graph_t* graph);
-
-int create_window(Window* w, char* title, int width, int height, int fps, int xpos, int ypos);
+void graph_copy_points_(graph_t* graph, int x, const float* ys, int n);
+void graph_claim_(graph_t* graph, int n);
+void graph_publish_(graph_t* graph, int n);
+void graph_notify_(graph_t* graph);
+int graph_snapshot_(graph_t* graph);
+void graph_transform_y_scalar_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale);
+#ifdef GRAPHING_SIMD
+void graph_transform_y_sse2_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale);
+GRAPHING_TARGET_AVX2 void graph_transform_y_avx2_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale);
+#endif
+void graph_transform_y_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale);
+void graph_mip_update_(graph_t* graph, int x, int n);
+void graph_mip_touch_(graph_t* graph, int x, int n);
+int graph_mip_level_(graph_t* graph);
+int graph_snapshot_mip_(graph_t* graph, int level, int* npoints);
+int graph_envelope_fold_(graph_t* graph, const float* points, SDL_FPoint* out, int pos);
+int graph_snapshot_envelope_(graph_t* graph, int* npoints);
+void graph_draw_scroll_(graph_t* graph);
+void graph_draw_points_(graph_t* graph);
+void graph_draw_value_(graph_t* graph);
+void graph_draw_stats_(graph_t* graph);
+void graph_stats_reset_(graph_t* graph);
+void graph_stats_step_(graph_stats_state_t* st, const float* points, int n, int p, float in);
+void graph_stats_exact_(graph_t* graph, int k);
+void graph_stats_rebuild_(graph_t* graph, int count);
+void graph_stats_write_(graph_t* graph, const float* ys, int n);
+void graph_stats_publish_(graph_t* graph);
+uint8_t graph_thin_lines_(graph_t* graph);
+uint8_t graph_plain_(graph_t* graph);
+void graph_geometry_reserve_(graph_t* graph, int nquads);
+void graph_geometry_quad_(graph_t* graph, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color color);
+void graph_geometry_segment_(graph_t* graph, float x0, float y0, float x1, float y1, float hw, SDL_Color color);
+void graph_geometry_lines_(graph_t* graph, const SDL_FPoint* pts, int n, float width, uint8_t step, SDL_Color color);
+void graph_geometry_fill_(graph_t* graph, const SDL_FPoint* pts, int n, uint8_t step, SDL_Color color);
+void graph_geometry_submit_(graph_t* graph);
+int graph_pool_thread_(void* data);
+void graph_pool_work_(graph_pool_t* pool, int self);
+uint8_t graph_raster_prepare_(graph_t* graph);
+void graph_raster_release_(graph_t* graph);
+void graph_raster_lines_(uint32_t* px, int w, int h, const SDL_FPoint* pts, int n, uint32_t color);
+void graph_raster_(void* ctx, int i);
+int graph_raster_draw_(graph_pool_t* pool, graph_t** graphs, int ngraphs, SDL_Renderer* only);
+uint8_t graph_background_(graph_t* graph);
+graph_atlas_t* graph_atlas_(SDL_Renderer* renderer, TTF_Font* font);
+void graph_atlas_release_(SDL_Renderer* renderer, TTF_Font* font);
+
+int create_window(Window* w, char* title, int width, int height, int fps, int xpos, int ypos, uint8_t vsync);
 void close_window(Window* w);
+void window_count_frame_(Window* w);
+void window_set_state_(Window* w, uint8_t state);
+uint8_t window_due_(Window* w);
+uint8_t window_handle_event_(Window* w, const SDL_Event* e);
+int graph_load_(uint32_t sdl_flags);
 
 
 /* */
@@ -332,6 +727,7 @@ graph_setup_t* graph_blank_setup()
 		.height                = GRAPHING_DEFAULT_HEIGHT,
 		.xpos                  = SDL_WINDOWPOS_UNDEFINED,
 		.ypos                  = SDL_WINDOWPOS_UNDEFINED,
+		.dashboard             = NULL,
 
 		// Graph settings
 		.graph_amp             = GRAPHING_DEFAULT_AMP,
@@ -350,6 +746,20 @@ graph_setup_t* graph_blank_setup()
 		.bg_color              = {GRAPHING_DEFAULT_BG_COLOR},
 		.plot_color            = {GRAPHING_DEFAULT_PLOT_COLOR},
 
+		.show_value            = 0,
+		.stats                 = 0,
+		.show_stats            = 0,
+		.series                = 1,
+		.series_colors         = NULL,
+		.style                 = GRAPHING_STYLE_LINE,
+		.fill                  = 0,
+		.line_width            = 1.0f,
+		.scroll                = 0,
+		.notify                = NULL,
+		.refresh               = GRAPHING_DEFAULT_REFRESH,
+		.vsync                 = 1,
+		.mipmap                = 0,
+
 		// Control whether this struct gets freed after 1 use (default=YES)
 		// Anything user-allocated is not freed !!
 		.consume               = 1,
@@ -507,10 +917,24 @@ graph_t* graph_create(graph_setup_t* setup)
 	int len = strlen(setup->title);
 	len = (len > 128) ? 128 : len;
 	
-	graph->window.title = (char*) malloc(len + 1); // char*
-	snprintf(graph->window.title, len + 1, "%s", setup->title);
-
-	create_window(&graph->window, graph->window.title, setup->width, setup->height, -1, setup->xpos, setup->ypos);
+	char* title = (char*) malloc(len + 1); // char*
+	snprintf(title, len + 1, "%s", setup->title);
+
+	if (setup->dashboard != NULL) {
+		// Tile of a shared window, everything below is drawn relative to the viewport
+		graph->window = setup->dashboard->window;
+		graph->window.title = title;
+		graph->window.width = setup->width;
+		graph->window.height = setup->height;
+		graph->viewport = (SDL_Rect){setup->xpos, setup->ypos, setup->width, setup->height};
+		graph->owns_window = 0;
+	} else {
+		create_window(&graph->window, title, setup->width, setup->height, -1, setup->xpos, setup->ypos, setup->vsync);
+		graph->viewport = (SDL_Rect){0, 0, setup->width, setup->height};
+		graph->owns_window = 1;
+		graph->window.refresh = setup->refresh;
+		window_set_state_(&graph->window, (uint8_t) SDL_AtomicGet(&graph->window.state));
+	}
 
 	graph->graph_amp 	= setup->graph_amp;
 	graph->graph_n 		= setup->graph_n;
@@ -545,6 +969,7 @@ graph_t* graph_create(graph_setup_t* setup)
 	graph->xsegment_size		= graph->graph_n / graph->xsegments;
 	graph->real_ysegment_size	= graph->real_ysize / (2 * graph->ysegments); // pixels size of a segment
 	graph->real_xsegment_size	= graph->real_xsize / graph->xsegments;
+	graph->yscale				= (float)graph->real_ysize / (2 * graph->graph_amp);
 
 	// Setup segment texts
 
@@ -625,18 +1050,101 @@ graph_t* graph_create(graph_setup_t* setup)
 	graph->mutex = SDL_CreateMutex();
 	#endif
 
+	graph->notify = setup->notify;
+	SDL_AtomicSet(&graph->generation, 1);
+	graph->_drawn_generation = 0;
+
 	// Initialize data buffer
 	graph->pos = 0;
-
-	graph->points_f = (float*) malloc(sizeof(*graph->points_f) * graph->graph_n); // float*
-	for (int i = 0; i < graph->graph_n; i++)
+	SDL_AtomicSet(&graph->claim, 0);
+	SDL_AtomicSet(&graph->head, 0);
+	graph->seq_wrap = (graph->graph_n <= (1 << 29)) ? (1 << 30) / graph->graph_n * graph->graph_n : graph->graph_n;
+
+	graph->series = (setup->series < 1) ? 1 : (setup->series > GRAPHING_MAX_SERIES) ? GRAPHING_MAX_SERIES : setup->series;
+	graph->series_color[0] = graph->plot_color;
+	for (int k = 1; k < graph->series; k++)
+		graph->series_color[k] = (setup->series_colors != NULL) ? setup->series_colors[k-1] : g_graphing_palette[(k-1) % ARR_SIZE(g_graphing_palette)];
+	graph->style = setup->style;
+	graph->fill = setup->fill;
+	graph->line_width = (setup->line_width > 0.0f) ? setup->line_width : 1.0f;
+	graph->_geom_verts = NULL;
+	graph->_geom_indices = NULL;
+	graph->_geom_nverts = graph->_geom_nindices = 0;
+	graph->_geom_capacity = 0;
+
+	const size_t total = (size_t) graph->series * graph->graph_n;
+	graph->points_f = (float*) malloc(sizeof(*graph->points_f) * total); // float*
+	for (size_t i = 0; i < total; i++)
 		graph->points_f[i] = 0.0f;
 	
-	graph->_render_points_f = (SDL_FPoint*) malloc(sizeof(*graph->_render_points_f) * graph->graph_n); // SDL_FPoint*
+	graph->_render_points_f = (SDL_FPoint*) malloc(sizeof(*graph->_render_points_f) * total); // SDL_FPoint*
 
 	const float xscale = (float)graph->real_xsize / graph->graph_n;
-	for (int xx = 0; xx < graph->graph_n; xx++)
-		graph->_render_points_f[xx] = (SDL_FPoint){graph->xstart + xscale * xx + 1, (float)graph->zeroy};
+	for (size_t xx = 0; xx < total; xx++)
+		graph->_render_points_f[xx] = (SDL_FPoint){graph->xstart + xscale * (xx % graph->graph_n) + 1, (float)graph->zeroy};
+
+	// Min/max pyramid, all zeroes just like the points
+	graph->mip_levels = 0;
+	if (setup->mipmap && graph->series == 1) {
+		for (int count = graph->graph_n; count > 1 && graph->mip_levels < GRAPHING_MAX_MIP_LEVELS; graph->mip_levels++) {
+			count = (count + 1) / 2;
+			graph->mip_count[graph->mip_levels] = count;
+			graph->mip[graph->mip_levels] = (float*) calloc(2 * count, sizeof(float)); // float*
+		}
+	}
+
+	// Pyramid levels used for drawing have at most 2 buckets per pixel column, 2 vertices each;
+	// the envelope has 4 vertices per column
+	graph->_render_env_f = NULL;
+	graph->_env_stride = 4 * graph->real_xsize + 4;
+	if (graph->mip_levels > 0 || graph->graph_n > graph->real_xsize)
+		graph->_render_env_f = (SDL_FPoint*) malloc(sizeof(*graph->_render_env_f) * graph->_env_stride * graph->series); // SDL_FPoint*
+
+	graph->show_value = setup->show_value;
+	graph->show_stats = setup->show_stats;
+
+	// Sliding-window statistics, empty until the first append
+	graph->_stats = NULL;
+	graph->_stats_out = NULL;
+	SDL_AtomicSet(&graph->_stats_version, 0);
+	if (setup->stats || setup->show_stats) {
+		graph->_stats = (graph_stats_state_t*) calloc(graph->series, sizeof(*graph->_stats)); // graph_stats_state_t*
+		graph->_stats_out = (graph_stats_t*) calloc(graph->series, sizeof(*graph->_stats_out)); // graph_stats_t*
+		for (int k = 0; k < graph->series; k++) {
+			graph->_stats[k].minq = (int*) malloc(sizeof(int) * graph->graph_n); // int*
+			graph->_stats[k].maxq = (int*) malloc(sizeof(int) * graph->graph_n); // int*
+		}
+	}
+
+	graph->_background = NULL;
+	graph->_background_reset = 1;
+	graph->_background_builds = 0;
+
+	graph->_raster_pixels = NULL;
+	graph->_raster_background = NULL;
+	graph->_raster_builds = -1;
+	graph->_raster_tex = NULL;
+	graph->_raster_drawn = 0;
+
+	// Scrolling plot textures, as tall as the window so points past graph_amp still show
+	graph->_scroll_tex[0] = graph->_scroll_tex[1] = NULL;
+	graph->_scroll_cur = 0;
+	graph->_scroll_head = 0;
+	graph->_scroll_total = 0;
+	graph->_scroll_off = 0;
+	graph->_scroll_reset = 1;
+	if (setup->scroll && graph_plain_(graph) && SDL_RenderTargetSupported(graph->window.renderer)) {
+		for (int i = 0; i < 2; i++) {
+			graph->_scroll_tex[i] = SDL_CreateTexture(graph->window.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+				graph->real_xsize + 2, graph->window.height);
+		}
+		if (graph->_scroll_tex[0] == NULL || graph->_scroll_tex[1] == NULL) {
+			printf("Scroll texture could not be created, redrawing fully instead! SDL_Error: %s\n", SDL_GetError());
+			SDL_DestroyTexture(graph->_scroll_tex[0]);
+			SDL_DestroyTexture(graph->_scroll_tex[1]);
+			graph->_scroll_tex[0] = graph->_scroll_tex[1] = NULL;
+		}
+	}
 
 	// Draw initial sidebar & segment texts
 	graph_init_render_(graph);
@@ -653,7 +1161,12 @@ graph_t* graph_create(graph_setup_t* setup)
 void graph_init_render_(graph_t* graph)
 {
 	SDL_SetRenderDrawColor(graph->window.renderer, graph->bg_color.r, graph->bg_color.g, graph->bg_color.b, GRAPHING_DEFAULT_BG_ALPHA);
-	SDL_RenderClear(graph->window.renderer);
+	if (graph->owns_window) {
+		SDL_RenderClear(graph->window.renderer);
+	} else {
+		SDL_RenderSetViewport(graph->window.renderer, &graph->viewport);
+		SDL_RenderFillRect(graph->window.renderer, NULL);
+	}
 	SDL_SetRenderDrawColor(graph->window.renderer, graph->fg_color.r, graph->fg_color.g, graph->fg_color.b, GRAPHING_DEFAULT_FG_ALPHA);
 	// Redraw sidebar_scale
 	SDL_RenderDrawLines(graph->window.renderer, &graph->sidebar_scale[0], ARR_SIZE(graph->sidebar_scale));
@@ -666,6 +1179,66 @@ void graph_init_render_(graph_t* graph)
 }
 
 
+/*
+ *  Makes sure _background is up to date, (re)drawing it if needed: background
+ *  color, grid lines at every x/y segment, axes and y labels. Returns 0 if the
+ *  renderer can't draw to textures, in which case graph_draw() does it by hand.
+ */
+uint8_t graph_background_(graph_t* graph)
+{
+	SDL_Renderer* renderer = graph->window.renderer;
+	const graph_background_key_t key = {graph->fg_color, graph->bg_color, graph->window.width, graph->window.height};
+
+	if (graph->_background != NULL && !graph->_background_reset && memcmp(&key, &graph->_background_key, sizeof(key)) == 0)
+		return 1;
+
+	if (graph->_background != NULL && (key.width != graph->_background_key.width || key.height != graph->_background_key.height)) {
+		SDL_DestroyTexture(graph->_background);
+		graph->_background = NULL;
+	}
+	if (graph->_background == NULL) {
+		if (!SDL_RenderTargetSupported(renderer))
+			return 0;
+		graph->_background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, key.width, key.height);
+		if (graph->_background == NULL)
+			return 0;
+		SDL_SetTextureBlendMode(graph->_background, SDL_BLENDMODE_NONE);
+	}
+
+	graph->_background_reset = 0;
+	graph->_background_key = key;
+	graph->_background_builds++;
+
+	SDL_SetRenderTarget(renderer, graph->_background);
+	SDL_SetRenderDrawColor(renderer, graph->bg_color.r, graph->bg_color.g, graph->bg_color.b, GRAPHING_DEFAULT_BG_ALPHA);
+	SDL_RenderClear(renderer);
+
+	// Grid, a quarter of the way from the background to the foreground color
+	SDL_SetRenderDrawColor(renderer,
+		(3 * graph->bg_color.r + graph->fg_color.r) / 4,
+		(3 * graph->bg_color.g + graph->fg_color.g) / 4,
+		(3 * graph->bg_color.b + graph->fg_color.b) / 4,
+		GRAPHING_DEFAULT_BG_ALPHA);
+	for (int i = 0; i < 2 * graph->ysegments + 1 && graph->real_ysegment_size > 0; i++) {
+		const int y = graph->ystart + i * graph->real_ysegment_size;
+		SDL_RenderDrawLine(renderer, graph->xstart, y, graph->xend, y);
+	}
+	for (int i = 1; i <= graph->xsegments && graph->real_xsegment_size > 0; i++) {
+		const int x = graph->xstart + i * graph->real_xsegment_size;
+		SDL_RenderDrawLine(renderer, x, graph->ystart, x, graph->yend);
+	}
+
+	SDL_SetRenderDrawColor(renderer, graph->fg_color.r, graph->fg_color.g, graph->fg_color.b, GRAPHING_DEFAULT_FG_ALPHA);
+	SDL_RenderDrawLines(renderer, &graph->sidebar_scale[0], ARR_SIZE(graph->sidebar_scale));
+
+	for (int i = 0; i < graph->ysegment_count; i++)
+		SDL_RenderCopy(renderer, graph->ysegment_texts[i].texture, NULL, &(graph->ysegment_texts[i].rect));
+
+	SDL_SetRenderTarget(renderer, NULL);
+	return 1;
+}
+
+
 /* */
 void graph_destroy(graph_t* graph)
 {
@@ -680,189 +1253,2136 @@ void graph_destroy(graph_t* graph)
 		SDL_DestroyTexture(graph->ysegment_texts[i].texture);
 	free(graph->ysegment_texts);
 
-	close_window(&graph->window);
+	// Textures go before the window: destroying its renderer frees them along with it
+	if (graph->_background != NULL)
+		SDL_DestroyTexture(graph->_background);
+	graph_raster_release_(graph);
+	if (graph->_scroll_tex[0] != NULL) {
+		SDL_DestroyTexture(graph->_scroll_tex[0]);
+		SDL_DestroyTexture(graph->_scroll_tex[1]);
+	}
+
+	if (graph->owns_window)
+		close_window(&graph->window);
 
 	#ifdef GRAPHING_NO_CACHING
 	if (graph->font) {
+		if (!graph->owns_window)
+			graph_atlas_release_(graph->window.renderer, graph->font);
 		TTF_CloseFont(graph->font);
 		graph->font = NULL;
 	}
 	#endif
 	
+	for (int k = 0; k < graph->mip_levels; k++)
+		free(graph->mip[k]);
+	free(graph->_render_env_f);
+
+	if (graph->_stats != NULL) {
+		for (int k = 0; k < graph->series; k++) {
+			free(graph->_stats[k].minq);
+			free(graph->_stats[k].maxq);
+		}
+		free(graph->_stats);
+		free(graph->_stats_out);
+	}
+
 	free(graph->points_f);
 	free(graph->_render_points_f);
+	free(graph->_geom_verts);
+	free(graph->_geom_indices);
 	free(graph->window.title);
 	free(graph);
 }
 
 
-/* */
-void graph_render(graph_t* graph)
+/* out[i].y = zeroy - ys[i] * yscale, leaving out[i].x alone */
+void graph_transform_y_scalar_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale)
 {
-	// TODO: save color and restore after
+	for (int i = 0; i < n; i++)
+		out[i].y = zeroy - ys[i] * yscale;
+}
 
-	SDL_Rect fillRect = {graph->xstart - 1, graph->ystart - 1, graph->xend, graph->yend};
-	SDL_SetRenderDrawColor(graph->window.renderer, graph->bg_color.r, graph->bg_color.g, graph->bg_color.b, GRAPHING_DEFAULT_BG_ALPHA); // white-grayish
 
-	SDL_RenderFillRect(graph->window.renderer, &fillRect);
-	// SDL_RenderClear(graph->window.renderer);
+#ifdef GRAPHING_SIMD
+/* 4 points at a time; y values are duplicated into both halves of each pair and masked into the odd lanes */
+void graph_transform_y_sse2_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale)
+{
+	const __m128 vzero = _mm_set1_ps(zeroy);
+	const __m128 vscale = _mm_set1_ps(yscale);
+	const __m128 ymask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, -1, 0));
+	float* o = (float*) out;
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 y = _mm_sub_ps(vzero, _mm_mul_ps(_mm_loadu_ps(ys + i), vscale));
+		__m128 lo = _mm_unpacklo_ps(y, y); // y0 y0 y1 y1
+		__m128 hi = _mm_unpackhi_ps(y, y); // y2 y2 y3 y3
+		__m128 o0 = _mm_loadu_ps(o + 2*i);
+		__m128 o1 = _mm_loadu_ps(o + 2*i + 4);
+		_mm_storeu_ps(o + 2*i, _mm_or_ps(_mm_andnot_ps(ymask, o0), _mm_and_ps(ymask, lo)));
+		_mm_storeu_ps(o + 2*i + 4, _mm_or_ps(_mm_andnot_ps(ymask, o1), _mm_and_ps(ymask, hi)));
+	}
+	graph_transform_y_scalar_(out + i, ys + i, n - i, zeroy, yscale);
+}
+
 
-	SDL_SetRenderDrawColor(graph->window.renderer, graph->fg_color.r, graph->fg_color.g, graph->fg_color.b, GRAPHING_DEFAULT_FG_ALPHA); // black 
-	// Redraw sidebar_scale
-	SDL_RenderDrawLines(graph->window.renderer, &graph->sidebar_scale[0], ARR_SIZE(graph->sidebar_scale));
+/* 8 points at a time */
+GRAPHING_TARGET_AVX2 void graph_transform_y_avx2_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale)
+{
+	const __m256 vzero = _mm256_set1_ps(zeroy);
+	const __m256 vscale = _mm256_set1_ps(yscale);
+	float* o = (float*) out;
+	int i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256 y = _mm256_sub_ps(vzero, _mm256_mul_ps(_mm256_loadu_ps(ys + i), vscale));
+		__m256 lo = _mm256_unpacklo_ps(y, y); // y0 y0 y1 y1 | y4 y4 y5 y5
+		__m256 hi = _mm256_unpackhi_ps(y, y); // y2 y2 y3 y3 | y6 y6 y7 y7
+		__m256 p0 = _mm256_permute2f128_ps(lo, hi, 0x20); // points 0..3
+		__m256 p1 = _mm256_permute2f128_ps(lo, hi, 0x31); // points 4..7
+		_mm256_storeu_ps(o + 2*i, _mm256_blend_ps(_mm256_loadu_ps(o + 2*i), p0, 0xAA));
+		_mm256_storeu_ps(o + 2*i + 8, _mm256_blend_ps(_mm256_loadu_ps(o + 2*i + 8), p1, 0xAA));
+	}
+	graph_transform_y_sse2_(out + i, ys + i, n - i, zeroy, yscale);
+}
+#endif
 
-	// Draw points
-	const float yscale = (float)graph->real_ysize / (2 * graph->graph_amp);
 
-	int oidx = 0;
+/* Picks the widest kernel the CPU supports on first use; short spans are no faster
+ * with them than with the loop the compiler vectorizes on its own */
+void graph_transform_y_(SDL_FPoint* out, const float* ys, int n, float zeroy, float yscale)
+{
+	#ifdef GRAPHING_SIMD
+		static int avx2 = -1;
+		if (avx2 < 0)
+			avx2 = SDL_HasAVX2() ? 1 : 0;
+
+		if (n < GRAPHING_SIMD_MIN_POINTS)
+			graph_transform_y_scalar_(out, ys, n, zeroy, yscale);
+		else if (avx2)
+			graph_transform_y_avx2_(out, ys, n, zeroy, yscale);
+		else
+			graph_transform_y_sse2_(out, ys, n, zeroy, yscale);
+	#else
+		graph_transform_y_scalar_(out, ys, n, zeroy, yscale);
+	#endif
+}
+
+
+/*
+ *  Transforms the points into _render_points_f, oldest first, without ever
+ *  blocking the writer. Whatever the writer claimed while the points were
+ *  being read is exactly the oldest few (it overwrites from head onwards),
+ *  so the returned index is the first render point known to be consistent;
+ *  the ones before it are left out of this frame.
+ */
+int graph_snapshot_(graph_t* graph)
+{
+	const int n = graph->graph_n;
+	const float yscale = graph->yscale;
+	int dirty = n;
+
+	for (int attempt = 0; attempt < 3 && dirty >= n; attempt++) {
+		const int head = SDL_AtomicGet(&graph->head);
+		const int pos = head % n;
+
+		// [pos, last], then [first, pos), of every series against the same head
+		for (int k = 0; k < graph->series; k++) {
+			SDL_FPoint* out = &graph->_render_points_f[(size_t) k * n];
+			const float* points = &graph->points_f[(size_t) k * n];
+			graph_transform_y_(&out[0], &points[pos], n - pos, (float)graph->zeroy, yscale);
+			graph_transform_y_(&out[n - pos], &points[0], pos, (float)graph->zeroy, yscale);
+		}
 
-	// [pos, last]
-	for (int xx = graph->pos; xx < graph->graph_n; xx++,oidx++) {
-		float yy = graph->points_f[xx];
-		graph->_render_points_f[oidx].y = graph->zeroy - (yy * yscale);
+		SDL_MemoryBarrierAcquire();
+		dirty = (SDL_AtomicGet(&graph->claim) - head + graph->seq_wrap) % graph->seq_wrap;
 	}
-	// [first, pos)
-	for (int xx = 0; xx < graph->pos; xx++,oidx++) {
-		float yy = graph->points_f[xx];
-		graph->_render_points_f[oidx].y = graph->zeroy - (yy * yscale);
+
+	return (dirty < n) ? dirty : n;
+}
+
+
+/* Pyramid level to draw from (the finest with at most 2 buckets per pixel), 0 for raw points */
+int graph_mip_level_(graph_t* graph)
+{
+	if (graph->mip_levels == 0 || graph->graph_n <= 2 * graph->real_xsize)
+		return 0;
+
+	for (int k = 1; k <= graph->mip_levels; k++)
+		if (graph->mip_count[k-1] <= 2 * graph->real_xsize)
+			return k;
+	return graph->mip_levels;
+}
+
+
+/*
+ *  Same as graph_snapshot_() but from pyramid `level`: every bucket becomes a
+ *  vertical min-max span at the x of its oldest point, alternating direction
+ *  so the connecting segments stay short. The bucket that holds both the
+ *  newest and the oldest points (unless head is aligned to it) is left out.
+ *  Fills _render_env_f; returns the first consistent point, *npoints is the total.
+ */
+int graph_snapshot_mip_(graph_t* graph, int level, int* npoints)
+{
+	const int n = graph->graph_n;
+	const int size = 1 << level;
+	const int count = graph->mip_count[level-1];
+	const float* mip = graph->mip[level-1];
+	const float xscale = (float)graph->real_xsize / n;
+	const float yscale = graph->yscale;
+	SDL_FPoint* out = graph->_render_env_f;
+
+	int dirty = n;
+	int nout = 0;
+
+	for (int attempt = 0; attempt < 3 && dirty >= n; attempt++) {
+		const int head = SDL_AtomicGet(&graph->head);
+		const int pos = head % n;
+		const uint8_t split = (pos & (size - 1)) != 0;
+		int b = (pos >> level) + split;
+
+		nout = 0;
+		for (int t = 0; t < count - split; t++, b++) {
+			if (b == count)
+				b = 0;
+
+			const int ts = (b * size - pos + n) % n; // age of the bucket's oldest point
+			const float x = graph->xstart + xscale * ts + 1;
+			const float ylo = graph->zeroy - mip[2*b] * yscale;
+			const float yhi = graph->zeroy - mip[2*b + 1] * yscale;
+
+			out[nout++] = (SDL_FPoint){x, (t & 1) ? yhi : ylo};
+			out[nout++] = (SDL_FPoint){x, (t & 1) ? ylo : yhi};
+		}
+
+		SDL_MemoryBarrierAcquire();
+		dirty = (SDL_AtomicGet(&graph->claim) - head + graph->seq_wrap) % graph->seq_wrap;
 	}
 
-	SDL_SetRenderDrawColor(graph->window.renderer, graph->plot_color.r, graph->plot_color.g, graph->plot_color.b, GRAPHING_DEFAULT_PLOT_ALPHA);
-	SDL_RenderDrawLinesF(graph->window.renderer, &(graph->_render_points_f)[0], graph->graph_n);
-	SDL_RenderPresent(graph->window.renderer);
+	*npoints = nout;
+	if (dirty >= n)
+		return nout;
+
+	// Buckets starting among the points claimed meanwhile might be torn
+	const float xdirty = graph->xstart + xscale * dirty + 1;
+	int first = 0;
+	while (first < nout && out[first].x < xdirty)
+		first += 2;
+	return first;
 }
 
 
-/* */
-void graph_addpoint(graph_t* graph, int x, float y)
+/* Envelope of one series, oldest column first; returns the number of vertices */
+int graph_envelope_fold_(graph_t* graph, const float* points, SDL_FPoint* out, int pos)
 {
-	#ifdef GRAPHING_USE_MUTEX
-		SDL_LockMutex(graph->mutex);
-	#endif
+	const int n = graph->graph_n;
+	const int w = graph->real_xsize;
+	const float yscale = graph->yscale;
+
+	int nout = 0;
+	int t0 = 0;
+	int i = pos;
+	for (int col = 0; col < w; col++) {
+		// Points of age [t0, t1) land in this column, at least one since n > w
+		const int t1 = (int)(((int64_t)(col + 1) * n + w - 1) / w);
+
+		float yy = points[i];
+		float first = yy, mn = yy, mx = yy;
+		for (int t = t0 + 1; t < t1; t++) {
+			if (++i == n)
+				i = 0;
+			yy = points[i];
+			if (yy < mn) mn = yy;
+			if (yy > mx) mx = yy;
+		}
+		if (++i == n)
+			i = 0;
+
+		const float x = (float)(graph->xstart + col + 1);
+		out[nout++] = (SDL_FPoint){x, graph->zeroy - first * yscale};
+		out[nout++] = (SDL_FPoint){x, graph->zeroy - mn * yscale};
+		out[nout++] = (SDL_FPoint){x, graph->zeroy - mx * yscale};
+		out[nout++] = (SDL_FPoint){x, graph->zeroy - yy * yscale};
+		t0 = t1;
+	}
+	return nout;
+}
 
-	graph->points_f[x] = y;
 
-	#ifdef GRAPHING_USE_MUTEX
-		SDL_UnlockMutex(graph->mutex);
-	#endif
+/*
+ *  Same as graph_snapshot_() but folds the points falling into each pixel
+ *  column into its first, min, max and last value, so a graph with far more
+ *  points than pixels costs 4 vertices per column to draw (a vertical span
+ *  plus the connectors to its neighbours) and keeps every spike visible.
+ *  Requires graph_n > real_xsize. Fills _render_env_f (series k from
+ *  k * _env_stride on); returns the first consistent vertex, *npoints is
+ *  the total, both the same for every series.
+ */
+int graph_snapshot_envelope_(graph_t* graph, int* npoints)
+{
+	const int n = graph->graph_n;
+	const int w = graph->real_xsize;
+
+	int dirty = n;
+	int nout = 0;
+
+	for (int attempt = 0; attempt < 3 && dirty >= n; attempt++) {
+		const int head = SDL_AtomicGet(&graph->head);
+		const int pos = head % n;
+
+		for (int k = 0; k < graph->series; k++)
+			nout = graph_envelope_fold_(graph, &graph->points_f[(size_t) k * n], &graph->_render_env_f[(size_t) k * graph->_env_stride], pos);
+
+		SDL_MemoryBarrierAcquire();
+		dirty = (SDL_AtomicGet(&graph->claim) - head + graph->seq_wrap) % graph->seq_wrap;
+	}
+
+	*npoints = nout;
+	if (dirty >= n)
+		return nout;
+
+	// Columns holding any of the points claimed meanwhile might be torn
+	const int torn = (dirty > 0) ? (int)((int64_t)(dirty - 1) * w / n) + 1 : 0;
+	return 4 * torn;
 }
 
 
 /* */
-void graph_appendpoint(graph_t* graph, float y)
+void graph_render(graph_t* graph)
 {
-	#ifdef GRAPHING_USE_MUTEX
-		SDL_LockMutex(graph->mutex);
-	#endif
+	graph_draw(graph);
+	graph_present(graph);
+}
 
-	graph->points_f[graph->pos] = y; // graph_addpoint(graph, graph->pos, y);
-	graph->pos = (graph->pos + 1) % graph->graph_n;
-	
-	#ifdef GRAPHING_USE_MUTEX
-		SDL_UnlockMutex(graph->mutex);
-	#endif
+
+/* Tiles are presented with their dashboard */
+void graph_present(graph_t* graph)
+{
+	if (graph->owns_window) {
+		SDL_RenderPresent(graph->window.renderer);
+		window_count_frame_(&graph->window);
+	}
 }
 
 
 /* */
-int graph_load()
+void graph_handle_event(graph_t* graph, const SDL_Event* e)
 {
-	/*
-		(*) sdl init fail:			00000001 1
-		(*) img load fail:			00001000 1<<3
-		(*) ttf load fail:			00010000 1<<4
-		(*) mixer open fail:		00100000 1<<5
-		(*) net open fail:			01000000 1<<6
-	*/
-	
-	unsigned int error = 0;
+	if (graph->owns_window && window_handle_event_(&graph->window, e))
+		graph_invalidate(graph);
+}
 
-	// Initialize SDL
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
-		printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
-		error |= 1;
-		return error; // fatal
+
+/* */
+uint8_t graph_due(graph_t* graph)
+{
+	return !graph->owns_window || window_due_(&graph->window);
+}
+
+
+/* Dashboard tiles get their whole tile redrawn since the window is shared and cleared every frame */
+void graph_draw(graph_t* graph)
+{
+	// TODO: save color and restore after
+
+	// Anything written from here on makes the graph count as changed again
+	graph->_drawn_generation = SDL_AtomicGet(&graph->generation);
+
+	if (graph_background_(graph)) {
+		SDL_Rect all = {0, 0, graph->window.width, graph->window.height};
+		if (!graph->owns_window)
+			SDL_RenderSetViewport(graph->window.renderer, &graph->viewport);
+		SDL_RenderCopy(graph->window.renderer, graph->_background, NULL, &all);
+
+	} else {
+		// No render targets, draw it all by hand
+		if (!graph->owns_window)
+			graph_init_render_(graph);
+
+		SDL_Rect fillRect = {graph->xstart - 1, graph->ystart - 1, graph->xend, graph->yend};
+		SDL_SetRenderDrawColor(graph->window.renderer, graph->bg_color.r, graph->bg_color.g, graph->bg_color.b, GRAPHING_DEFAULT_BG_ALPHA); // white-grayish
+
+		SDL_RenderFillRect(graph->window.renderer, &fillRect);
+		// SDL_RenderClear(graph->window.renderer);
+
+		SDL_SetRenderDrawColor(graph->window.renderer, graph->fg_color.r, graph->fg_color.g, graph->fg_color.b, GRAPHING_DEFAULT_FG_ALPHA); // black 
+		// Redraw sidebar_scale
+		SDL_RenderDrawLines(graph->window.renderer, &graph->sidebar_scale[0], ARR_SIZE(graph->sidebar_scale));
 	}
 
-	// Fonts
-	if (TTF_Init() == -1) {
-		printf("SDL_TTF cannot initialize! Error: %s\n", TTF_GetError());
-		error |= 1<<4;
+	if (graph->_scroll_tex[0] != NULL) {
+		graph_draw_scroll_(graph);
+	} else {
+		graph_draw_points_(graph);
 	}
 
-	/* if(SDLNet_Init() == -1) {
-		printf("SDL_net cannot initialize! Error: %s\n", SDLNet_GetError());
-		error |= 1<<6;
-	} */
+	graph_draw_value_(graph);
+	graph_draw_stats_(graph);
+}
 
-	// Hint to fix some window focus issues
-	SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
 
-	// [!] Try to fix flickering
-	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "direct3d");
-	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "direct3d12");
-	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
-	// #ifdef __linux__
-	// 	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
-    // 	SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_BYPASS_COMPOSITOR, "2");
-	// #endif
+/* Newest value, which changes every frame */
+void graph_draw_value_(graph_t* graph)
+{
+	if (!graph->show_value || graph->font == NULL)
+		return;
 
-	return error;
+	char buff[32];
+	const int newest = (SDL_AtomicGet(&graph->head) + graph->graph_n - 1) % graph->graph_n;
+	snprintf(buff, sizeof(buff), "%.6g", graph->points_f[newest]);
+	const int w = graph_text_width(graph->window.renderer, graph->font, buff);
+	graph_text(graph->window.renderer, graph->font, buff, (float)(graph->xend - w), 0.0f, graph->fg_color);
 }
 
 
-/* */
-int create_window(Window* w, char* title, int width, int height, int fps, int xpos, int ypos)
+/* Window statistics of series 0, left aligned with the plot, on the line below the value if it's shown */
+void graph_draw_stats_(graph_t* graph)
 {
-	/*
-		(*) window creation fail:	00000010 1<<1
-		(*) renderer creation fail:	00000100 1<<2
-	*/
+	graph_stats_t st;
+	if (!graph->show_stats || graph->font == NULL || !graph_stats(graph, 0, &st) || st.count == 0)
+		return;
 
-	unsigned int error = 0;
+	char buff[96];
+	snprintf(buff, sizeof(buff), "min %.3g max %.3g mean %.3g sd %.3g", st.min, st.max, st.mean, st.stddev);
+	const float y = graph->show_value ? (float)TTF_FontHeight(graph->font) : 0.0f;
+	graph_text(graph->window.renderer, graph->font, buff, (float)graph->xstart, y, graph->fg_color);
+}
 
-	w->title = title;
-	w->width = width;
-	w->height = height;
-	if (fps < 1)
-		fps = 60;
-	w->fps = fps;
 
-	// Create app window
-	// int xpos = randint(500,0); // SDL_WINDOWPOS_UNDEFINED;
-	// int ypos = randint(500,0); // SDL_WINDOWPOS_UNDEFINED;
-	if (xpos == -1) xpos = SDL_WINDOWPOS_UNDEFINED;
-	if (ypos == -1) ypos = SDL_WINDOWPOS_UNDEFINED;
+/* */
+void graph_draw_points_(graph_t* graph)
+{
 
-	w->window = SDL_CreateWindow(w->title, xpos, ypos, w->width, w->height, SDL_WINDOW_SHOWN);
-	if (w->window == NULL) {
-		printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
-		error |= 1<<1;
-		return error; // fatal
+	// Draw points, or their min/max summary if there are more of them than pixel columns
+	SDL_FPoint* points = graph->_render_points_f;
+	int npoints = graph->graph_n;
+	int first;
+
+	int level = graph_mip_level_(graph);
+	if (level > 0) {
+		points = graph->_render_env_f;
+		first = graph_snapshot_mip_(graph, level, &npoints);
+	} else if (graph->graph_n > graph->real_xsize) {
+		points = graph->_render_env_f;
+		first = graph_snapshot_envelope_(graph, &npoints);
+	} else {
+		first = graph_snapshot_(graph);
 	}
 
-	// Create renderer for the window
-	w->renderer = SDL_CreateRenderer(w->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-	if (w->renderer == NULL) {
-		printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
-		error |= 1<<2;
-		return error; // fatal
+	// Anything past one plain 1 px line goes out as one batch of triangles: the areas of
+	// every series first, then their lines on top
+	if (!graph_plain_(graph)) {
+		const int stride = (points == graph->_render_env_f) ? graph->_env_stride : graph->graph_n;
+		for (int k = 0; k < graph->series && graph->fill && npoints - first > 1; k++) {
+			SDL_Color c = graph->series_color[k];
+			c.a = GRAPHING_DEFAULT_FILL_ALPHA;
+			graph_geometry_fill_(graph, &points[(size_t) k * stride + first], npoints - first, graph->style == GRAPHING_STYLE_STEP, c);
+		}
+		for (int k = 0; k < graph->series && npoints - first > 1; k++)
+			graph_geometry_lines_(graph, &points[(size_t) k * stride + first], npoints - first, graph->line_width, graph->style == GRAPHING_STYLE_STEP, graph->series_color[k]);
+		graph_geometry_submit_(graph);
+		return;
 	}
 
-	//Init renderer color
-	SDL_SetRenderDrawColor(w->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+	SDL_SetRenderDrawColor(graph->window.renderer, graph->plot_color.r, graph->plot_color.g, graph->plot_color.b, GRAPHING_DEFAULT_PLOT_ALPHA);
+	if (npoints - first > 1)
+		SDL_RenderDrawLinesF(graph->window.renderer, &points[first], npoints - first);
+}
 
-	return error;
+
+/* Unstyled 1 px lines, whatever the number of series: what CPU rasterization can draw */
+uint8_t graph_thin_lines_(graph_t* graph)
+{
+	return graph->style == GRAPHING_STYLE_LINE && !graph->fill && graph->line_width == 1.0f;
 }
 
 
-/* */
-void close_window(Window* w)
+/* Single series, 1 px lines: drawn with SDL_RenderDrawLinesF (and eligible for scrolling) */
+uint8_t graph_plain_(graph_t* graph)
 {
-	SDL_DestroyRenderer(w->renderer);
-	SDL_DestroyWindow(w->window);
-	w->renderer = NULL;
-	w->window = NULL;
+	return graph->series == 1 && graph_thin_lines_(graph);
+}
+
+
+/* Makes room for nquads more quads (4 vertices, 6 indices each) */
+void graph_geometry_reserve_(graph_t* graph, int nquads)
+{
+	const int need = graph->_geom_nverts / 4 + nquads;
+	if (need <= graph->_geom_capacity)
+		return;
+
+	graph->_geom_capacity = (need > 2 * graph->_geom_capacity) ? need : 2 * graph->_geom_capacity;
+	graph->_geom_verts = (SDL_Vertex*) realloc(graph->_geom_verts, sizeof(*graph->_geom_verts) * 4 * graph->_geom_capacity); // SDL_Vertex*
+	graph->_geom_indices = (int*) realloc(graph->_geom_indices, sizeof(*graph->_geom_indices) * 6 * graph->_geom_capacity); // int*
+}
+
+
+/* Triangles abc and acd; room must have been reserved */
+void graph_geometry_quad_(graph_t* graph, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color color)
+{
+	SDL_Vertex* v = &graph->_geom_verts[graph->_geom_nverts];
+	int* idx = &graph->_geom_indices[graph->_geom_nindices];
+	const int base = graph->_geom_nverts;
+
+	v[0] = (SDL_Vertex){a, color, {0.0f, 0.0f}};
+	v[1] = (SDL_Vertex){b, color, {0.0f, 0.0f}};
+	v[2] = (SDL_Vertex){c, color, {0.0f, 0.0f}};
+	v[3] = (SDL_Vertex){d, color, {0.0f, 0.0f}};
+	idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+	idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+
+	graph->_geom_nverts += 4;
+	graph->_geom_nindices += 6;
+}
+
+
+/*
+ *  Segment as a quad hw to each side, extended by hw at both ends so
+ *  consecutive segments overlap at the joints (and a zero length one
+ *  still shows as a square). Expects pixel center coordinates.
+ */
+void graph_geometry_segment_(graph_t* graph, float x0, float y0, float x1, float y1, float hw, SDL_Color color)
+{
+	float dx = x1 - x0, dy = y1 - y0;
+	const float len = SDL_sqrtf(dx * dx + dy * dy);
+	if (len > 1e-6f) {
+		dx *= hw / len;
+		dy *= hw / len;
+	} else {
+		dx = hw;
+		dy = 0.0f;
+	}
+
+	// Along the segment (dx, dy), across it (-dy, dx)
+	graph_geometry_quad_(graph,
+		(SDL_FPoint){x0 - dx - dy, y0 - dy + dx},
+		(SDL_FPoint){x1 + dx - dy, y1 + dy + dx},
+		(SDL_FPoint){x1 + dx + dy, y1 + dy - dx},
+		(SDL_FPoint){x0 - dx + dy, y0 - dy - dx},
+		color);
+}
+
+
+/*
+ *  Polyline `width` pixels wide, or with `step` a staircase holding every
+ *  value until the next point's x. Points are offset to pixel centers, so a
+ *  1 px line covers the same pixels SDL_RenderDrawLinesF would.
+ */
+void graph_geometry_lines_(graph_t* graph, const SDL_FPoint* pts, int n, float width, uint8_t step, SDL_Color color)
+{
+	if (n < 2)
+		return;
+
+	const float hw = 0.5f * width;
+	graph_geometry_reserve_(graph, step ? 2 * (n - 1) : n - 1);
+
+	for (int i = 1; i < n; i++) {
+		const float x0 = pts[i-1].x + 0.5f, y0 = pts[i-1].y + 0.5f;
+		const float x1 = pts[i].x + 0.5f, y1 = pts[i].y + 0.5f;
+		if (step) {
+			graph_geometry_segment_(graph, x0, y0, x1, y0, hw, color);
+			graph_geometry_segment_(graph, x1, y0, x1, y1, hw, color);
+		} else {
+			graph_geometry_segment_(graph, x0, y0, x1, y1, hw, color);
+		}
+	}
+}
+
+
+/*
+ *  Area between the polyline (or staircase) and the zero line, one quad per
+ *  segment; a segment crossing the zero line becomes two triangles meeting
+ *  at the crossing, so the quad doesn't fold over itself.
+ */
+void graph_geometry_fill_(graph_t* graph, const SDL_FPoint* pts, int n, uint8_t step, SDL_Color color)
+{
+	if (n < 2)
+		return;
+
+	const float base = graph->zeroy + 0.5f;
+	graph_geometry_reserve_(graph, 2 * (n - 1));
+
+	for (int i = 1; i < n; i++) {
+		const float x0 = pts[i-1].x + 0.5f, y0 = pts[i-1].y + 0.5f;
+		const float x1 = pts[i].x + 0.5f, y1 = step ? y0 : pts[i].y + 0.5f;
+
+		if ((y0 - base) * (y1 - base) < 0.0f) {
+			const float xc = x0 + (x1 - x0) * (base - y0) / (y1 - y0);
+			const SDL_FPoint c = {xc, base};
+			graph_geometry_quad_(graph, (SDL_FPoint){x0, y0}, c, c, (SDL_FPoint){x0, base}, color);
+			graph_geometry_quad_(graph, c, (SDL_FPoint){x1, y1}, (SDL_FPoint){x1, base}, c, color);
+		} else {
+			graph_geometry_quad_(graph, (SDL_FPoint){x0, y0}, (SDL_FPoint){x1, y1}, (SDL_FPoint){x1, base}, (SDL_FPoint){x0, base}, color);
+		}
+	}
+}
+
+
+/* Draws everything appended since the last submit with one call, blended for the translucent fills */
+void graph_geometry_submit_(graph_t* graph)
+{
+	if (graph->_geom_nindices > 0) {
+		SDL_SetRenderDrawBlendMode(graph->window.renderer, SDL_BLENDMODE_BLEND);
+		SDL_RenderGeometry(graph->window.renderer, NULL, graph->_geom_verts, graph->_geom_nverts, graph->_geom_indices, graph->_geom_nindices);
+		SDL_SetRenderDrawBlendMode(graph->window.renderer, SDL_BLENDMODE_NONE);
+	}
+	graph->_geom_nverts = 0;
+	graph->_geom_nindices = 0;
+}
+
+
+/*
+ *  Scrolling mode: point number j (counting every point ever appended) sits at
+ *  texture x = xscale * j - _scroll_off, where _scroll_off only grows by whole
+ *  pixels, so moving the plot left is a plain texture copy into the other
+ *  texture. Only the segments from the previous newest point onwards are
+ *  drawn; the remaining fraction of a pixel is applied when the texture is
+ *  copied to the window. Anything that can't be scrolled (random writes,
+ *  lost textures, more than graph_n new points, torn reads) redraws fully.
+ */
+void graph_draw_scroll_(graph_t* graph)
+{
+	SDL_Renderer* renderer = graph->window.renderer;
+	const int n = graph->graph_n;
+	const int wrap = graph->seq_wrap;
+	const double xscale = (double)graph->real_xsize / n;
+	const float yscale = graph->yscale;
+	const int tw = graph->real_xsize + 2;
+	const int th = graph->window.height;
+	SDL_FPoint* pts = graph->_render_points_f;
+
+	const int head = SDL_AtomicGet(&graph->head);
+	const int pos = head % n;
+	const int fresh = (head - graph->_scroll_head + wrap) % wrap;
+
+	uint8_t full = graph->_scroll_reset || fresh >= n;
+	graph->_scroll_reset = 0;
+	if (fresh == 0 && !full)
+		goto blit;
+
+	{
+		const long long total = graph->_scroll_total + fresh;
+		const double base = xscale * (double)(total - n); // x of the oldest point, before the offset
+		const long long off = (long long) SDL_floor(base);
+		const float frac = (float)(base - off);
+
+		// Ages of the points to draw, oldest first: all of them, or the previous newest onwards
+		const int from = full ? 0 : n - fresh - 1;
+		int np = 0;
+		for (int t = from; t < n; t++, np++) {
+			int idx = pos + t;
+			if (idx >= n)
+				idx -= n;
+			pts[np] = (SDL_FPoint){frac + (float)(xscale * t), graph->zeroy - graph->points_f[idx] * yscale};
+		}
+
+		SDL_MemoryBarrierAcquire();
+		const int dirty = (SDL_AtomicGet(&graph->claim) - head + wrap) % wrap;
+		int first = 0;
+		if (dirty > from) {
+			first = (dirty - from < np) ? dirty - from : np;
+			graph->_scroll_reset = 1; // torn points are left out, so redo everything next frame
+		}
+
+		SDL_Texture* cur = graph->_scroll_tex[graph->_scroll_cur];
+		const long long shift = off - graph->_scroll_off;
+
+		if (full || shift > 0) {
+			SDL_Texture* next = graph->_scroll_tex[1 - graph->_scroll_cur];
+			SDL_SetRenderTarget(renderer, next);
+			SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+			SDL_RenderClear(renderer);
+
+			if (!full && shift < tw) {
+				SDL_Rect src = {(int)shift, 0, tw - (int)shift, th};
+				SDL_Rect dst = {0, 0, tw - (int)shift, th};
+				SDL_SetTextureBlendMode(cur, SDL_BLENDMODE_NONE);
+				SDL_RenderCopy(renderer, cur, &src, &dst);
+			}
+			graph->_scroll_cur = 1 - graph->_scroll_cur;
+		} else {
+			SDL_SetRenderTarget(renderer, cur);
+		}
+
+		SDL_SetRenderDrawColor(renderer, graph->plot_color.r, graph->plot_color.g, graph->plot_color.b, GRAPHING_DEFAULT_PLOT_ALPHA);
+		if (np - first > 1)
+			SDL_RenderDrawLinesF(renderer, &pts[first], np - first);
+		SDL_SetRenderTarget(renderer, NULL);
+
+		graph->_scroll_head = head;
+		graph->_scroll_total = total;
+		graph->_scroll_off = off;
+	}
+
+blit:
+	{
+		const double base = xscale * (double)(graph->_scroll_total - n);
+		const float frac = (float)(base - graph->_scroll_off);
+		SDL_Texture* cur = graph->_scroll_tex[graph->_scroll_cur];
+		SDL_FRect dst = {graph->xstart + 1 - frac, 0.0f, (float) tw, (float) th};
+		SDL_SetTextureBlendMode(cur, SDL_BLENDMODE_BLEND);
+		SDL_RenderCopyF(renderer, cur, NULL, &dst);
+	}
+}
+
+
+/* Keeps far out values finite and within int range; NaN stays NaN */
+static inline double graph_raster_guard_(float v)
+{
+	if (v > 16777216.0f)
+		return 16777216.0;
+	if (v < -16777216.0f)
+		return -16777216.0;
+	return v;
+}
+
+
+/* Liang-Barsky: cuts the segment down to its part within [0, w-1] x [0, h-1] without changing
+ * its slope; returns 0 if none of it is */
+static inline int graph_raster_clip_(double* x0, double* y0, double* x1, double* y1, int w, int h)
+{
+	const double dx = *x1 - *x0;
+	const double dy = *y1 - *y0;
+	const double p[4] = {-dx, dx, -dy, dy};
+	const double q[4] = {*x0, (w - 1) - *x0, *y0, (h - 1) - *y0};
+	double t0 = 0.0, t1 = 1.0;
+
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0)
+				return 0; // parallel to this edge and outside of it
+			continue;
+		}
+		const double t = q[i] / p[i];
+		if (p[i] < 0.0) {
+			if (t > t1)
+				return 0;
+			if (t > t0)
+				t0 = t;
+		} else {
+			if (t < t0)
+				return 0;
+			if (t < t1)
+				t1 = t;
+		}
+	}
+
+	const double ox = *x0, oy = *y0;
+	*x0 = ox + t0 * dx;
+	*y0 = oy + t0 * dy;
+	*x1 = ox + t1 * dx;
+	*y1 = oy + t1 * dy;
+	return 1;
+}
+
+
+/* Pixel of a clipped coordinate, rounding error kept inside the buffer */
+static inline int graph_raster_coord_(double v, int size)
+{
+	const int c = (int) SDL_floor(v);
+	return (c < 0) ? 0 : (c >= size) ? size - 1 : c;
+}
+
+
+/* Bresenham through consecutive points, like SDL_RenderDrawLinesF; every segment is clipped
+ * to the buffer first, so one with an end far off screen keeps its direction */
+void graph_raster_lines_(uint32_t* px, int w, int h, const SDL_FPoint* pts, int n, uint32_t color)
+{
+	if (n == 1 && pts[0].x >= 0 && pts[0].x < w && pts[0].y >= 0 && pts[0].y < h)
+		px[(int) pts[0].y * w + (int) pts[0].x] = color;
+
+	for (int k = 1; k < n; k++) {
+		double fx0 = graph_raster_guard_(pts[k-1].x), fy0 = graph_raster_guard_(pts[k-1].y);
+		double fx1 = graph_raster_guard_(pts[k].x), fy1 = graph_raster_guard_(pts[k].y);
+		if (fx0 != fx0 || fy0 != fy0 || fx1 != fx1 || fy1 != fy1 || !graph_raster_clip_(&fx0, &fy0, &fx1, &fy1, w, h))
+			continue;
+
+		int x0 = graph_raster_coord_(fx0, w), y0 = graph_raster_coord_(fy0, h);
+		const int x1 = graph_raster_coord_(fx1, w), y1 = graph_raster_coord_(fy1, h);
+		const int dx = (x1 > x0) ? x1 - x0 : x0 - x1, sx = (x0 < x1) ? 1 : -1;
+		const int dy = (y1 > y0) ? y0 - y1 : y1 - y0, sy = (y0 < y1) ? 1 : -1;
+		int err = dx + dy;
+
+		while (1) {
+			px[y0 * w + x0] = color;
+			if (x0 == x1 && y0 == y1)
+				break;
+			const int e2 = 2 * err;
+			if (e2 >= dy) { err += dy; x0 += sx; }
+			if (e2 <= dx) { err += dx; y0 += sy; }
+		}
+	}
+}
+
+
+/*
+ *  Render thread part of rasterizing: (re)builds the background texture and
+ *  reads it back into memory when it changed, makes sure the buffers and the
+ *  streaming texture exist. Returns 0 if the graph can only be drawn through
+ *  the renderer (no render targets), graph_draw() is used for it instead.
+ */
+uint8_t graph_raster_prepare_(graph_t* graph)
+{
+	SDL_Renderer* renderer = graph->window.renderer;
+	const int w = graph->window.width;
+	const int h = graph->window.height;
+
+	// Styled lines need the triangles, any number of 1 px series is rasterized on the CPU
+	if (!graph_thin_lines_(graph))
+		return 0;
+	if (!graph_background_(graph))
+		return 0;
+
+	if (graph->_raster_tex == NULL) {
+		graph->_raster_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+		graph->_raster_pixels = (uint32_t*) malloc(sizeof(uint32_t) * w * h); // uint32_t*
+		graph->_raster_background = (uint32_t*) malloc(sizeof(uint32_t) * w * h); // uint32_t*
+		graph->_raster_builds = -1;
+		if (graph->_raster_tex == NULL || graph->_raster_pixels == NULL || graph->_raster_background == NULL) {
+			graph_raster_release_(graph);
+			return 0;
+		}
+		SDL_SetTextureBlendMode(graph->_raster_tex, SDL_BLENDMODE_NONE);
+	}
+
+	if (graph->_raster_builds != graph->_background_builds) {
+		SDL_SetRenderTarget(renderer, graph->_background);
+		const int failed = SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, graph->_raster_background, w * 4);
+		SDL_SetRenderTarget(renderer, NULL);
+		if (failed != 0) {
+			graph_raster_release_(graph);
+			return 0;
+		}
+		graph->_raster_builds = graph->_background_builds;
+	}
+	return 1;
+}
+
+
+/* Drops the texture and buffers, so the graph goes back to being drawn by graph_draw() */
+void graph_raster_release_(graph_t* graph)
+{
+	if (graph->_raster_tex != NULL)
+		SDL_DestroyTexture(graph->_raster_tex);
+	free(graph->_raster_pixels);
+	free(graph->_raster_background);
+	graph->_raster_tex = NULL;
+	graph->_raster_pixels = NULL;
+	graph->_raster_background = NULL;
+	graph->_raster_builds = -1;
+	graph->_raster_drawn = 0;
+}
+
+
+/* Pool task: the plot of graphs[i] over its background, touching nothing but the graph's own memory */
+void graph_raster_(void* ctx, int i)
+{
+	graph_t* graph = ((graph_t**) ctx)[i];
+	const int w = graph->window.width;
+	const int h = graph->window.height;
+	memcpy(graph->_raster_pixels, graph->_raster_background, sizeof(uint32_t) * w * h);
+
+	SDL_FPoint* points = graph->_render_points_f;
+	int npoints = graph->graph_n;
+	int first;
+
+	int level = graph_mip_level_(graph);
+	if (level > 0) {
+		points = graph->_render_env_f;
+		first = graph_snapshot_mip_(graph, level, &npoints);
+	} else if (graph->graph_n > graph->real_xsize) {
+		points = graph->_render_env_f;
+		first = graph_snapshot_envelope_(graph, &npoints);
+	} else {
+		first = graph_snapshot_(graph);
+	}
+
+	const int stride = (points == graph->_render_env_f) ? graph->_env_stride : graph->graph_n;
+	for (int k = 0; k < graph->series && npoints - first > 1; k++) {
+		const SDL_Color c = graph->series_color[k];
+		const uint32_t color = 0xFF000000u | ((uint32_t) c.r << 16) | ((uint32_t) c.g << 8) | c.b;
+		graph_raster_lines_(graph->_raster_pixels, w, h, &points[(size_t) k * stride + first], npoints - first, color);
+	}
+	graph->_raster_drawn = 1;
+}
+
+
+/* */
+int graph_raster_draw(graph_pool_t* pool, graph_t** graphs, int ngraphs)
+{
+	return graph_raster_draw_(pool, graphs, ngraphs, NULL);
+}
+
+
+/* Graphs drawn by some other renderer than `only` (if set) are left alone */
+int graph_raster_draw_(graph_pool_t* pool, graph_t** graphs, int ngraphs, SDL_Renderer* only)
+{
+	if (pool->batch_capacity < ngraphs) {
+		pool->batch_capacity = ngraphs;
+		pool->batch = (void**) realloc(pool->batch, sizeof(*pool->batch) * ngraphs); // void**
+	}
+
+	// Only the render thread may touch the renderers, so everything needing one happens here
+	int nbatch = 0;
+	for (int i = 0; i < ngraphs; i++) {
+		graph_t* graph = graphs[i];
+		if (only != NULL && graph->window.renderer != only)
+			continue;
+		if ((graph_changed(graph) || graph->_raster_tex == NULL) && graph_raster_prepare_(graph)) {
+			graph->_drawn_generation = SDL_AtomicGet(&graph->generation);
+			pool->batch[nbatch++] = graph;
+		}
+	}
+
+	graph_pool_run(pool, nbatch, graph_raster_, pool->batch);
+
+	for (int i = 0; i < ngraphs; i++) {
+		graph_t* graph = graphs[i];
+		if (only != NULL && graph->window.renderer != only)
+			continue;
+		if (graph->_raster_tex == NULL) {
+			graph_draw(graph);
+			continue;
+		}
+
+		if (graph->_raster_drawn) {
+			SDL_UpdateTexture(graph->_raster_tex, NULL, graph->_raster_pixels, graph->window.width * 4);
+			graph->_raster_drawn = 0;
+		}
+		if (!graph->owns_window)
+			SDL_RenderSetViewport(graph->window.renderer, &graph->viewport);
+		SDL_Rect all = {0, 0, graph->window.width, graph->window.height};
+		SDL_RenderCopy(graph->window.renderer, graph->_raster_tex, NULL, &all);
+		graph_draw_value_(graph);
+		graph_draw_stats_(graph);
+	}
+	return nbatch;
+}
+
+
+/* Workers sleep until a batch starts; one that runs out of tasks steals instead */
+int graph_pool_thread_(void* data)
+{
+	graph_pool_t* pool = (graph_pool_t*) data;
+
+	const int self = SDL_AtomicAdd(&pool->started, 1);
+
+	while (1) {
+		SDL_SemWait(pool->start);
+		if (pool->quit)
+			break;
+		graph_pool_work_(pool, self);
+	}
+	return 0;
+}
+
+
+/*
+ *  Pops tasks from the front of its own queue; once that's empty, takes the
+ *  back half of the fullest-looking other queue and carries on. Returns when
+ *  no queue has anything left, tasks taken by others may still be running.
+ */
+void graph_pool_work_(graph_pool_t* pool, int self)
+{
+	graph_pool_queue_t* own = &pool->queues[self];
+	const int nqueues = pool->nthreads + 1;
+
+	while (1) {
+		SDL_AtomicLock(&own->lock);
+		const int i = (own->begin < own->end) ? own->begin++ : -1;
+		SDL_AtomicUnlock(&own->lock);
+
+		if (i >= 0) {
+			pool->task(pool->ctx, i);
+			if (SDL_AtomicAdd(&pool->remaining, -1) == 1)
+				SDL_SemPost(pool->done);
+			continue;
+		}
+
+		// Steal
+		int victim = -1, most = 0;
+		for (int q = 0; q < nqueues; q++) {
+			if (q == self)
+				continue;
+			SDL_AtomicLock(&pool->queues[q].lock);
+			const int left = pool->queues[q].end - pool->queues[q].begin;
+			SDL_AtomicUnlock(&pool->queues[q].lock);
+			if (left > most) {
+				most = left;
+				victim = q;
+			}
+		}
+		if (victim < 0)
+			return;
+
+		graph_pool_queue_t* other = &pool->queues[victim];
+		SDL_AtomicLock(&other->lock);
+		const int left = other->end - other->begin;
+		const int from = other->end - (left + 1) / 2;
+		const int to = other->end;
+		if (left > 0)
+			other->end = from;
+		SDL_AtomicUnlock(&other->lock);
+
+		if (left > 0) {
+			SDL_AtomicLock(&own->lock);
+			own->begin = from;
+			own->end = to;
+			SDL_AtomicUnlock(&own->lock);
+		}
+	}
+}
+
+
+/* */
+graph_pool_t* graph_pool_create(int nthreads)
+{
+	if (nthreads <= 0)
+		nthreads = SDL_GetCPUCount() - 1;
+	if (nthreads < 0)
+		nthreads = 0;
+
+	// Pick the transform kernel now rather than racing on it from the workers
+	graph_transform_y_(NULL, NULL, 0, 0.0f, 0.0f);
+
+	graph_pool_t* pool = (graph_pool_t*) calloc(1, sizeof(*pool)); // graph_pool_t*
+	pool->queues = (graph_pool_queue_t*) calloc(nthreads + 1, sizeof(*pool->queues)); // graph_pool_queue_t*
+	pool->threads = (SDL_Thread**) calloc(nthreads + 1, sizeof(*pool->threads)); // SDL_Thread**
+	pool->start = SDL_CreateSemaphore(0);
+	pool->done = SDL_CreateSemaphore(0);
+
+	for (int t = 0; t < nthreads; t++) {
+		pool->threads[t] = SDL_CreateThread(graph_pool_thread_, "graphing pool", (void*) pool);
+		if (pool->threads[t] == NULL)
+			break;
+		pool->nthreads++;
+	}
+	return pool;
+}
+
+
+/* Contiguous shares per thread to begin with, so neighbouring tasks mostly stay on one core */
+void graph_pool_run(graph_pool_t* pool, int ntasks, void (*task)(void* ctx, int i), void* ctx)
+{
+	if (ntasks <= 0)
+		return;
+
+	const int nqueues = pool->nthreads + 1;
+	pool->task = task;
+	pool->ctx = ctx;
+	SDL_AtomicSet(&pool->remaining, ntasks);
+	for (int q = 0; q < nqueues; q++) {
+		SDL_AtomicLock(&pool->queues[q].lock);
+		pool->queues[q].begin = (int)((int64_t) ntasks * q / nqueues);
+		pool->queues[q].end = (int)((int64_t) ntasks * (q + 1) / nqueues);
+		SDL_AtomicUnlock(&pool->queues[q].lock);
+	}
+
+	for (int t = 0; t < pool->nthreads && ntasks > 1; t++)
+		SDL_SemPost(pool->start);
+	graph_pool_work_(pool, nqueues - 1);
+	SDL_SemWait(pool->done);
+}
+
+
+/* */
+void graph_pool_destroy(graph_pool_t* pool)
+{
+	if (pool == NULL)
+		return;
+
+	pool->quit = 1;
+	for (int t = 0; t < pool->nthreads; t++)
+		SDL_SemPost(pool->start);
+	for (int t = 0; t < pool->nthreads; t++)
+		SDL_WaitThread(pool->threads[t], NULL);
+
+	SDL_DestroySemaphore(pool->start);
+	SDL_DestroySemaphore(pool->done);
+	free(pool->threads);
+	free(pool->queues);
+	free(pool->batch);
+	free(pool);
+}
+
+
+/* */
+void graph_addpoint(graph_t* graph, int x, float y)
+{
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_LockMutex(graph->mutex);
+	#endif
+
+	graph->points_f[x] = y;
+	graph_mip_touch_(graph, x, 1);
+	graph_stats_rebuild_(graph, -1);
+	graph_stats_publish_(graph);
+	graph->_scroll_reset = 1;
+	graph_notify_(graph);
+
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_UnlockMutex(graph->mutex);
+	#endif
+}
+
+
+/* */
+void graph_appendpoint(graph_t* graph, float y)
+{
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_LockMutex(graph->mutex);
+	#endif
+
+	graph_claim_(graph, 1);
+	if (graph->_stats != NULL) {
+		graph_stats_write_(graph, &y, 1);
+	} else {
+		graph->points_f[graph->pos] = y; // graph_addpoint(graph, graph->pos, y);
+		if (++graph->pos == graph->graph_n)
+			graph->pos = 0;
+	}
+	graph_publish_(graph, 1);
+	
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_UnlockMutex(graph->mutex);
+	#endif
+}
+
+
+/* Announces that n points from pos onwards are about to be overwritten */
+void graph_claim_(graph_t* graph, int n)
+{
+	SDL_AtomicSet(&graph->claim, (int)(((long long) SDL_AtomicGet(&graph->claim) + n) % graph->seq_wrap));
+}
+
+
+/* Makes n points written since the matching graph_claim_() (the last n before pos) visible
+ * to the renderer, bringing the pyramid up to date first */
+void graph_publish_(graph_t* graph, int n)
+{
+	if (graph->mip_levels > 0) {
+		const int m = (n < graph->graph_n) ? n : graph->graph_n;
+		graph_mip_touch_(graph, (graph->pos - m + graph->graph_n) % graph->graph_n, m);
+	}
+
+	SDL_AtomicSet(&graph->head, (int)(((long long) SDL_AtomicGet(&graph->head) + n) % graph->seq_wrap));
+	graph_notify_(graph);
+}
+
+
+/* Bumps the generation; the semaphore is only posted if nobody has been woken up yet */
+void graph_notify_(graph_t* graph)
+{
+	SDL_AtomicAdd(&graph->generation, 1);
+	if (graph->notify != NULL && SDL_SemValue(graph->notify) == 0)
+		SDL_SemPost(graph->notify);
+}
+
+
+/* */
+uint8_t graph_changed(graph_t* graph)
+{
+	return SDL_AtomicGet(&graph->generation) != graph->_drawn_generation;
+}
+
+
+/* Tiles share the dashboard's surface */
+SDL_Surface* graph_surface(graph_t* graph)
+{
+	return graph->window.surface;
+}
+
+
+/* */
+void graph_invalidate(graph_t* graph)
+{
+	graph->_background_reset = 1;
+	graph->_scroll_reset = 1;
+	graph_notify_(graph);
+}
+
+
+/* Recomputes the pyramid buckets covering points [x, x+n), which must not wrap */
+void graph_mip_update_(graph_t* graph, int x, int n)
+{
+	int lo = x;
+	int hi = x + n - 1;
+	const float* prev = graph->points_f;
+	int prev_count = graph->graph_n;
+
+	for (int k = 0; k < graph->mip_levels; k++) {
+		float* cur = graph->mip[k];
+		lo >>= 1;
+		hi >>= 1;
+
+		for (int b = lo; b <= hi; b++) {
+			const int c0 = 2 * b;
+			const int c1 = c0 + 1;
+			float mn, mx;
+
+			if (k == 0) {
+				mn = mx = prev[c0];
+				if (c1 < prev_count) {
+					if (prev[c1] < mn) mn = prev[c1];
+					if (prev[c1] > mx) mx = prev[c1];
+				}
+			} else {
+				mn = prev[2*c0];
+				mx = prev[2*c0 + 1];
+				if (c1 < prev_count) {
+					if (prev[2*c1] < mn) mn = prev[2*c1];
+					if (prev[2*c1 + 1] > mx) mx = prev[2*c1 + 1];
+				}
+			}
+			cur[2*b] = mn;
+			cur[2*b + 1] = mx;
+		}
+
+		prev = cur;
+		prev_count = graph->mip_count[k];
+	}
+}
+
+
+/* Same as graph_mip_update_() but [x, x+n) may wrap around graph_n */
+void graph_mip_touch_(graph_t* graph, int x, int n)
+{
+	const int gn = graph->graph_n;
+	if (graph->mip_levels == 0 || n <= 0)
+		return;
+	if (n > gn)
+		n = gn;
+
+	x %= gn;
+	const int first = (n < gn - x) ? n : gn - x;
+	graph_mip_update_(graph, x, first);
+	if (n > first)
+		graph_mip_update_(graph, 0, n - first);
+}
+
+
+/*
+ *  Writes ys[0..n) to points [x, x+n) wrapping around at graph_n, as at most
+ *  two memcpys. Only the last graph_n values can survive so anything before
+ *  them is skipped. Does not lock.
+ */
+void graph_copy_points_(graph_t* graph, int x, const float* ys, int n)
+{
+	const int gn = graph->graph_n;
+
+	if (n > gn) {
+		x = (int)(((long long)x + n - gn) % gn);
+		ys += n - gn;
+		n = gn;
+	}
+
+	int first = gn - x;
+	if (first > n)
+		first = n;
+
+	memcpy(&graph->points_f[x], ys, sizeof(*ys) * first);
+	memcpy(&graph->points_f[0], ys + first, sizeof(*ys) * (n - first));
+}
+
+
+/* */
+void graph_addpoints(graph_t* graph, int x, const float* ys, int n)
+{
+	if (n <= 0)
+		return;
+
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_LockMutex(graph->mutex);
+	#endif
+
+	graph_copy_points_(graph, x, ys, n);
+	graph_mip_touch_(graph, x, n);
+	graph_stats_rebuild_(graph, -1);
+	graph_stats_publish_(graph);
+	graph->_scroll_reset = 1;
+	graph_notify_(graph);
+
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_UnlockMutex(graph->mutex);
+	#endif
+}
+
+
+/* */
+void graph_appendpoints(graph_t* graph, const float* ys, int n)
+{
+	if (n <= 0)
+		return;
+
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_LockMutex(graph->mutex);
+	#endif
+
+	graph_claim_(graph, n);
+	if (graph->_stats != NULL) {
+		graph_stats_write_(graph, ys, n);
+	} else {
+		graph_copy_points_(graph, graph->pos, ys, n);
+		graph->pos = (int)(((long long)graph->pos + n) % graph->graph_n);
+	}
+	graph_publish_(graph, n);
+
+	#ifdef GRAPHING_USE_MUTEX
+		SDL_UnlockMutex(graph->mutex);
+	#endif
+}
+
+
+/*
+ *  Transposes a row-major block (rows x channels, like the program's input)
+ *  into the graphs. Rows are taken a tile at a time, sized to stay in L1
+ *  while every graph copies its column out of it, so each graph's points
+ *  are written sequentially and the source is read from cache.
+ */
+void graph_appendrows(graph_t** graphs, int ngraphs, const float* rows, int nrows, int stride)
+{
+	if (nrows <= 0 || ngraphs <= 0)
+		return;
+
+	#ifdef GRAPHING_USE_MUTEX
+		for (int i = 0; i < ngraphs; i++)
+			SDL_LockMutex(graphs[i]->mutex);
+	#endif
+
+	// Rows that would be overwritten within this same call are skipped, so a window
+	// that is about to be replaced whole starts over
+	for (int i = 0; i < ngraphs; i++) {
+		graph_claim_(graphs[i], nrows);
+		if (graphs[i]->_stats != NULL && nrows > graphs[i]->graph_n)
+			graph_stats_reset_(graphs[i]);
+	}
+
+	int tile_rows = GRAPHING_TILE_BYTES / (int)(sizeof(*rows) * stride);
+	if (tile_rows < 8)
+		tile_rows = 8;
+
+	for (int r0 = 0; r0 < nrows; r0 += tile_rows) {
+		const int r1 = (r0 + tile_rows < nrows) ? r0 + tile_rows : nrows;
+
+		int col = 0;
+		for (int i = 0; i < ngraphs; col += graphs[i]->series, i++) {
+			graph_t* graph = graphs[i];
+			const int gn = graph->graph_n;
+
+			// Rows that would be overwritten within this same call are skipped
+			const int skip = (nrows > gn) ? nrows - gn : 0;
+			if (r1 <= skip)
+				continue;
+			const int rs = (r0 > skip) ? r0 : skip;
+
+			int start = graph->pos;
+			if (skip > 0 && r0 <= skip)
+				start = (int)(((long long) start + skip) % gn);
+
+			int pos = start;
+			for (int k = 0; k < graph->series; k++) {
+				float* points = &graph->points_f[(size_t) k * gn];
+				const float* src = rows + (size_t) rs * stride + col + k;
+				graph_stats_state_t* st = (graph->_stats != NULL) ? &graph->_stats[k] : NULL;
+				pos = start;
+				for (int r = rs; r < r1; r++, src += stride) {
+					if (st != NULL)
+						graph_stats_step_(st, points, gn, pos, *src);
+					points[pos] = *src;
+					if (++pos == gn)
+						pos = 0;
+				}
+			}
+			graph->pos = pos;
+		}
+	}
+
+	for (int i = 0; i < ngraphs; i++) {
+		graph_stats_publish_(graphs[i]);
+		graph_publish_(graphs[i], nrows);
+	}
+
+	#ifdef GRAPHING_USE_MUTEX
+		for (int i = 0; i < ngraphs; i++)
+			SDL_UnlockMutex(graphs[i]->mutex);
+	#endif
+}
+
+
+/* */
+void graph_appendseries(graph_t* graph, const float* rows, int nrows)
+{
+	graph_appendrows(&graph, 1, rows, nrows, graph->series);
+}
+
+
+/* Empties the window of every series */
+void graph_stats_reset_(graph_t* graph)
+{
+	for (int k = 0; k < graph->series; k++) {
+		graph_stats_state_t* st = &graph->_stats[k];
+		st->min_front = st->min_len = 0;
+		st->max_front = st->max_len = 0;
+		st->count = 0;
+		st->shift = st->sum = st->sumsq = 0.0;
+		st->since_exact = 0;
+	}
+}
+
+
+/*
+ *  Moves one series' window forward by the point about to be written at index p
+ *  (call before writing `in` there): the point at p drops out if the window is
+ *  full, and `in` goes to the back of both deques after everything it beats.
+ *  Each index is pushed and popped at most once per write, O(1) amortized.
+ */
+void graph_stats_step_(graph_stats_state_t* st, const float* points, int n, int p, float in)
+{
+	if (st->count == n) {
+		const double out = points[p] - st->shift;
+		st->sum -= out;
+		st->sumsq -= out * out;
+
+		// The oldest point is at the front of a deque if it's in it at all
+		if (st->min_len > 0 && st->minq[st->min_front] == p) {
+			if (++st->min_front == n)
+				st->min_front = 0;
+			st->min_len--;
+		}
+		if (st->max_len > 0 && st->maxq[st->max_front] == p) {
+			if (++st->max_front == n)
+				st->max_front = 0;
+			st->max_len--;
+		}
+	} else {
+		st->count++;
+	}
+
+	const double d = in - st->shift;
+	st->sum += d;
+	st->sumsq += d * d;
+
+	int back = st->min_front + st->min_len - 1;
+	for (; st->min_len > 0 && points[st->minq[(back >= n) ? back - n : back]] >= in; back--)
+		st->min_len--;
+	back++;
+	st->minq[(back >= n) ? back - n : back] = p;
+	st->min_len++;
+
+	back = st->max_front + st->max_len - 1;
+	for (; st->max_len > 0 && points[st->maxq[(back >= n) ? back - n : back]] <= in; back--)
+		st->max_len--;
+	back++;
+	st->maxq[(back >= n) ? back - n : back] = p;
+	st->max_len++;
+
+	st->since_exact++;
+}
+
+
+/* Recomputes series k's sums from its window, shifted by their mean so the squares stay small */
+void graph_stats_exact_(graph_t* graph, int k)
+{
+	graph_stats_state_t* st = &graph->_stats[k];
+	const int n = graph->graph_n;
+	const float* points = &graph->points_f[(size_t) k * n];
+	const int start = (graph->pos - st->count + n) % n;
+
+	double sum = 0.0;
+	for (int i = 0, p = start; i < st->count; i++, p = (p + 1 == n) ? 0 : p + 1)
+		sum += points[p];
+	st->shift = (st->count > 0) ? sum / st->count : 0.0;
+
+	st->sum = st->sumsq = 0.0;
+	for (int i = 0, p = start; i < st->count; i++, p = (p + 1 == n) ? 0 : p + 1) {
+		const double d = points[p] - st->shift;
+		st->sum += d;
+		st->sumsq += d * d;
+	}
+	st->since_exact = 0;
+}
+
+
+/* Rebuilds every series' state from its last `count` points before pos (< 0: as many as
+ * are in the window now), after points were written without stepping the window */
+void graph_stats_rebuild_(graph_t* graph, int count)
+{
+	if (graph->_stats == NULL)
+		return;
+
+	const int n = graph->graph_n;
+	for (int k = 0; k < graph->series; k++) {
+		graph_stats_state_t* st = &graph->_stats[k];
+		const float* points = &graph->points_f[(size_t) k * n];
+		int c = (count < 0) ? st->count : count;
+		if (c > n)
+			c = n;
+
+		st->min_front = st->min_len = 0;
+		st->max_front = st->max_len = 0;
+		st->count = 0;
+		for (int i = 0, p = (graph->pos - c + n) % n; i < c; i++, p = (p + 1 == n) ? 0 : p + 1)
+			graph_stats_step_(st, points, n, p, points[p]);
+		graph_stats_exact_(graph, k);
+	}
+}
+
+
+/* Appends ys[0..n) to series 0 one point at a time, the other series keeping their values
+ * at the indices that become the newest; only the last graph_n values can survive */
+void graph_stats_write_(graph_t* graph, const float* ys, int n)
+{
+	const int gn = graph->graph_n;
+	int pos = graph->pos;
+
+	if (n > gn) {
+		graph_stats_reset_(graph);
+		pos = (int)(((long long) pos + n - gn) % gn);
+		ys += n - gn;
+		n = gn;
+	}
+
+	for (int i = 0; i < n; i++) {
+		graph_stats_step_(&graph->_stats[0], graph->points_f, gn, pos, ys[i]);
+		graph->points_f[pos] = ys[i];
+		for (int k = 1; k < graph->series; k++) {
+			const float* points = &graph->points_f[(size_t) k * gn];
+			graph_stats_step_(&graph->_stats[k], points, gn, pos, points[pos]);
+		}
+		if (++pos == gn)
+			pos = 0;
+	}
+	graph->pos = pos;
+	graph_stats_publish_(graph);
+}
+
+
+/* Copies every series' summary out for readers, recomputing sums that have drifted long enough */
+void graph_stats_publish_(graph_t* graph)
+{
+	if (graph->_stats == NULL)
+		return;
+
+	// The O(graph_n) rescans stay outside the version window readers spin on
+	for (int k = 0; k < graph->series; k++)
+		if (graph->_stats[k].since_exact >= graph->graph_n)
+			graph_stats_exact_(graph, k);
+
+	SDL_AtomicAdd(&graph->_stats_version, 1);
+	for (int k = 0; k < graph->series; k++) {
+		graph_stats_state_t* st = &graph->_stats[k];
+		graph_stats_t* out = &graph->_stats_out[k];
+		const float* points = &graph->points_f[(size_t) k * graph->graph_n];
+
+		out->count = st->count;
+		if (st->count == 0) {
+			out->min = out->max = 0.0f;
+			out->mean = out->stddev = 0.0;
+			continue;
+		}
+		const double m = st->sum / st->count;
+		const double var = st->sumsq / st->count - m * m;
+		out->min = points[st->minq[st->min_front]];
+		out->max = points[st->maxq[st->max_front]];
+		out->mean = st->shift + m;
+		out->stddev = (var > 0.0) ? SDL_sqrt(var) : 0.0;
+	}
+	SDL_AtomicAdd(&graph->_stats_version, 1);
+}
+
+
+/* Retries while the writer is publishing, so the copy is never half old and half new */
+uint8_t graph_stats(graph_t* graph, int series, graph_stats_t* out)
+{
+	if (graph->_stats == NULL || series < 0 || series >= graph->series)
+		return 0;
+
+	for (;;) {
+		const int version = SDL_AtomicGet(&graph->_stats_version);
+		if (version & 1) {
+			SDL_CPUPauseInstruction();
+			continue;
+		}
+		*out = graph->_stats_out[series];
+		SDL_MemoryBarrierAcquire();
+		if (SDL_AtomicGet(&graph->_stats_version) == version)
+			return 1;
+	}
+}
+
+
+/* */
+int graph_load()
+{
+	return graph_load_(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+}
+
+
+/* Events are still initialized so SDL_QUIT (e.g. from SIGINT) and timers work */
+int graph_load_headless()
+{
+	g_graphing_headless = 1;
+	return graph_load_(SDL_INIT_EVENTS);
+}
+
+
+/* */
+int graph_load_(uint32_t sdl_flags)
+{
+	/*
+		(*) sdl init fail:			00000001 1
+		(*) img load fail:			00001000 1<<3
+		(*) ttf load fail:			00010000 1<<4
+		(*) mixer open fail:		00100000 1<<5
+		(*) net open fail:			01000000 1<<6
+	*/
+	
+	unsigned int error = 0;
+
+	// Initialize SDL
+	if (SDL_Init(sdl_flags) < 0) {
+		printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+		error |= 1;
+		return error; // fatal
+	}
+
+	// Fonts
+	if (TTF_Init() == -1) {
+		printf("SDL_TTF cannot initialize! Error: %s\n", TTF_GetError());
+		error |= 1<<4;
+	}
+
+	/* if(SDLNet_Init() == -1) {
+		printf("SDL_net cannot initialize! Error: %s\n", SDLNet_GetError());
+		error |= 1<<6;
+	} */
+
+	// Hint to fix some window focus issues
+	SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
+
+	// [!] Try to fix flickering
+	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "direct3d");
+	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "direct3d12");
+	// // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+	// #ifdef __linux__
+	// 	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
+    // 	SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_BYPASS_COMPOSITOR, "2");
+	// #endif
+
+	return error;
+}
+
+
+/* */
+int create_window(Window* w, char* title, int width, int height, int fps, int xpos, int ypos, uint8_t vsync)
+{
+	/*
+		(*) window creation fail:	00000010 1<<1
+		(*) renderer creation fail:	00000100 1<<2
+	*/
+
+	unsigned int error = 0;
+
+	w->title = title;
+	w->width = width;
+	w->height = height;
+	if (fps < 1)
+		fps = 60;
+	w->fps = fps;
+	w->achieved_fps = 0.0f;
+	w->_frames = 0;
+	w->_fps_since = SDL_GetTicks64();
+	w->refresh = (graph_refresh_t) GRAPHING_DEFAULT_REFRESH;
+	w->_next_frame = 0;
+	SDL_AtomicSet(&w->_reschedule, 0);
+	window_set_state_(w, GRAPHING_WINDOW_FOCUSED); // headless surfaces are always "focused"
+
+	// Create app window
+	// int xpos = randint(500,0); // SDL_WINDOWPOS_UNDEFINED;
+	// int ypos = randint(500,0); // SDL_WINDOWPOS_UNDEFINED;
+	if (xpos == -1) xpos = SDL_WINDOWPOS_UNDEFINED;
+	if (ypos == -1) ypos = SDL_WINDOWPOS_UNDEFINED;
+
+	w->window = NULL;
+	w->surface = NULL;
+
+	// No display: draw into a surface instead, presenting is then a no-op
+	if (g_graphing_headless) {
+		w->surface = SDL_CreateRGBSurfaceWithFormat(0, w->width, w->height, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (w->surface == NULL) {
+			printf("Surface could not be created! SDL_Error: %s\n", SDL_GetError());
+			error |= 1<<1;
+			return error; // fatal
+		}
+		w->renderer = SDL_CreateSoftwareRenderer(w->surface);
+		if (w->renderer == NULL) {
+			printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
+			SDL_FreeSurface(w->surface);
+			w->surface = NULL;
+			error |= 1<<2;
+			return error; // fatal
+		}
+		SDL_SetRenderDrawColor(w->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+		return error;
+	}
+
+	w->window = SDL_CreateWindow(w->title, xpos, ypos, w->width, w->height, SDL_WINDOW_SHOWN);
+	if (w->window == NULL) {
+		printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
+		error |= 1<<1;
+		return error; // fatal
+	}
+
+	// Create renderer for the window
+	w->renderer = SDL_CreateRenderer(w->window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+	if (w->renderer == NULL) {
+		printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
+		SDL_DestroyWindow(w->window);
+		w->window = NULL;
+		error |= 1<<2;
+		return error; // fatal
+	}
+
+	//Init renderer color
+	SDL_SetRenderDrawColor(w->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+	// Only the window that gets focus hears about it
+	const uint32_t flags = SDL_GetWindowFlags(w->window);
+	if (flags & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN))
+		window_set_state_(w, GRAPHING_WINDOW_HIDDEN);
+	else if (!(flags & SDL_WINDOW_INPUT_FOCUS))
+		window_set_state_(w, GRAPHING_WINDOW_UNFOCUSED);
+
+	return error;
+}
+
+
+/* Call after every present of the window; also books its next refresh slot */
+void window_count_frame_(Window* w)
+{
+	w->_frames++;
+	window_fps(w);
+
+	const int fps = SDL_AtomicGet(&w->refresh_fps);
+	if (fps > 0) {
+		const uint64_t now = SDL_GetPerformanceCounter();
+		const uint64_t period = SDL_GetPerformanceFrequency() / fps;
+		w->_next_frame = (now - w->_next_frame < period) ? w->_next_frame + period : now + period;
+	}
+}
+
+
+/* */
+float window_fps(Window* w)
+{
+	const uint64_t now = SDL_GetTicks64();
+	if (now - w->_fps_since >= 1000) {
+		w->achieved_fps = (float)(w->_frames * 1000.0 / (now - w->_fps_since));
+		w->_frames = 0;
+		w->_fps_since = now;
+	}
+	return w->achieved_fps;
+}
+
+
+/* May be called from any thread, the render thread picks the change up on its next check */
+void window_set_state_(Window* w, uint8_t state)
+{
+	int fps;
+	switch (state) {
+		case GRAPHING_WINDOW_FOCUSED:   fps = w->refresh.focused; break;
+		case GRAPHING_WINDOW_UNFOCUSED: fps = w->refresh.unfocused; break;
+		default:                        fps = w->refresh.hidden; break;
+	}
+	SDL_AtomicSet(&w->refresh_fps, fps);
+	SDL_AtomicSet(&w->state, state);
+	SDL_AtomicSet(&w->_reschedule, 1); // a slower rate shouldn't hold back the next frame at a faster one
+}
+
+
+/* Returns 1 if the window just became visible again */
+uint8_t window_handle_event_(Window* w, const SDL_Event* e)
+{
+	if (w->window == NULL || e->type != SDL_WINDOWEVENT || e->window.windowID != SDL_GetWindowID(w->window))
+		return 0;
+
+	const uint8_t was = (uint8_t) SDL_AtomicGet(&w->state);
+	switch (e->window.event) {
+		case SDL_WINDOWEVENT_MINIMIZED:
+		case SDL_WINDOWEVENT_HIDDEN:
+			window_set_state_(w, GRAPHING_WINDOW_HIDDEN);
+			break;
+		case SDL_WINDOWEVENT_RESTORED:
+		case SDL_WINDOWEVENT_SHOWN:
+		case SDL_WINDOWEVENT_MAXIMIZED:
+			if (was == GRAPHING_WINDOW_HIDDEN)
+				window_set_state_(w, (SDL_GetWindowFlags(w->window) & SDL_WINDOW_INPUT_FOCUS) ? GRAPHING_WINDOW_FOCUSED : GRAPHING_WINDOW_UNFOCUSED);
+			break;
+		case SDL_WINDOWEVENT_FOCUS_GAINED:
+			window_set_state_(w, GRAPHING_WINDOW_FOCUSED);
+			break;
+		case SDL_WINDOWEVENT_FOCUS_LOST:
+			if (was != GRAPHING_WINDOW_HIDDEN)
+				window_set_state_(w, GRAPHING_WINDOW_UNFOCUSED);
+			break;
+	}
+	return was == GRAPHING_WINDOW_HIDDEN && SDL_AtomicGet(&w->state) != GRAPHING_WINDOW_HIDDEN;
+}
+
+
+/* Rate limiting only, whether there's anything new to draw is graph_changed()'s business;
+ * render thread only */
+uint8_t window_due_(Window* w)
+{
+	if (SDL_AtomicSet(&w->_reschedule, 0))
+		w->_next_frame = 0;
+
+	const int fps = SDL_AtomicGet(&w->refresh_fps);
+	if (fps == 0)
+		return 0;
+	return fps < 0 || SDL_GetPerformanceCounter() >= w->_next_frame;
+}
+
+
+/* */
+void close_window(Window* w)
+{
+	graph_atlas_release_(w->renderer, NULL);
+	SDL_DestroyRenderer(w->renderer);
+	if (w->window != NULL)
+		SDL_DestroyWindow(w->window);
+	if (w->surface != NULL)
+		SDL_FreeSurface(w->surface);
+	w->renderer = NULL;
+	w->window = NULL;
+	w->surface = NULL;
+}
+
+
+/* Finds or builds the atlas of font for renderer; NULL if the glyphs couldn't be rendered */
+graph_atlas_t* graph_atlas_(SDL_Renderer* renderer, TTF_Font* font)
+{
+	for (int i = 0; i < g_glyph_atlas_count; i++)
+		if (g_glyph_atlases[i]->renderer == renderer && g_glyph_atlases[i]->font == font)
+			return g_glyph_atlases[i];
+
+	const int nglyphs = GRAPHING_ATLAS_LAST - GRAPHING_ATLAS_FIRST + 1;
+	const int rows = (nglyphs + GRAPHING_ATLAS_COLUMNS - 1) / GRAPHING_ATLAS_COLUMNS;
+	const SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+
+	// Cells as wide as the widest glyph, as tall as the font
+	SDL_Surface* surfs[GRAPHING_ATLAS_LAST - GRAPHING_ATLAS_FIRST + 1];
+	int cellw = 1;
+	int cellh = TTF_FontHeight(font);
+	for (int i = 0; i < nglyphs; i++) {
+		surfs[i] = TTF_RenderGlyph_Blended(font, (Uint16)(GRAPHING_ATLAS_FIRST + i), white);
+		if (surfs[i] != NULL) {
+			if (surfs[i]->w > cellw) cellw = surfs[i]->w;
+			if (surfs[i]->h > cellh) cellh = surfs[i]->h;
+		}
+	}
+
+	graph_atlas_t* atlas = (graph_atlas_t*) calloc(1, sizeof(*atlas)); // graph_atlas_t*
+	atlas->renderer = renderer;
+	atlas->font = font;
+	atlas->height = cellh;
+
+	SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, cellw * GRAPHING_ATLAS_COLUMNS, cellh * rows, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (sheet != NULL) {
+		SDL_FillRect(sheet, NULL, 0);
+		for (int i = 0; i < nglyphs; i++) {
+			int minx, maxx, miny, maxy, advance = 0;
+			TTF_GlyphMetrics(font, (Uint16)(GRAPHING_ATLAS_FIRST + i), &minx, &maxx, &miny, &maxy, &advance);
+			atlas->advance[i] = advance;
+
+			SDL_Rect cell = {(i % GRAPHING_ATLAS_COLUMNS) * cellw, (i / GRAPHING_ATLAS_COLUMNS) * cellh, 0, 0};
+			if (surfs[i] != NULL) {
+				cell.w = surfs[i]->w;
+				cell.h = surfs[i]->h;
+				SDL_SetSurfaceBlendMode(surfs[i], SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(surfs[i], NULL, sheet, &cell);
+				cell.w = surfs[i]->w; // blit clips the rect
+				cell.h = surfs[i]->h;
+			}
+			atlas->glyphs[i] = cell;
+		}
+		atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+		SDL_FreeSurface(sheet);
+	}
+	for (int i = 0; i < nglyphs; i++)
+		SDL_FreeSurface(surfs[i]);
+
+	if (atlas->texture == NULL) {
+		printf("Glyph atlas could not be created! SDL_Error: %s\n", SDL_GetError());
+		free(atlas);
+		return NULL;
+	}
+	SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+	g_glyph_atlases = (graph_atlas_t**) realloc(g_glyph_atlases, sizeof(*g_glyph_atlases) * (g_glyph_atlas_count + 1)); // graph_atlas_t**
+	g_glyph_atlases[g_glyph_atlas_count++] = atlas;
+	return atlas;
+}
+
+
+/* Drops the atlases of a renderer or font about to be destroyed (NULL matches any) */
+void graph_atlas_release_(SDL_Renderer* renderer, TTF_Font* font)
+{
+	int kept = 0;
+	for (int i = 0; i < g_glyph_atlas_count; i++) {
+		graph_atlas_t* atlas = g_glyph_atlases[i];
+		if ((renderer == NULL || atlas->renderer == renderer) && (font == NULL || atlas->font == font)) {
+			SDL_DestroyTexture(atlas->texture);
+			free(atlas->verts);
+			free(atlas->indices);
+			free(atlas);
+		} else {
+			g_glyph_atlases[kept++] = atlas;
+		}
+	}
+	g_glyph_atlas_count = kept;
+	if (kept == 0) {
+		free(g_glyph_atlases);
+		g_glyph_atlases = NULL;
+	}
+}
+
+
+/* */
+int graph_text_width(SDL_Renderer* renderer, TTF_Font* font, const char* text)
+{
+	graph_atlas_t* atlas = graph_atlas_(renderer, font);
+	if (atlas == NULL)
+		return 0;
+
+	int w = 0;
+	for (const unsigned char* c = (const unsigned char*) text; *c; c++) {
+		int g = (*c >= GRAPHING_ATLAS_FIRST && *c <= GRAPHING_ATLAS_LAST) ? *c - GRAPHING_ATLAS_FIRST : '?' - GRAPHING_ATLAS_FIRST;
+		w += atlas->advance[g];
+	}
+	return w;
+}
+
+
+/* Two triangles per glyph, all in one SDL_RenderGeometry call */
+int graph_text(SDL_Renderer* renderer, TTF_Font* font, const char* text, float x, float y, SDL_Color color)
+{
+	graph_atlas_t* atlas = graph_atlas_(renderer, font);
+	if (atlas == NULL)
+		return 0;
+
+	const int len = (int) strlen(text);
+	if (len > atlas->capacity) {
+		atlas->capacity = (len > 2 * atlas->capacity) ? len : 2 * atlas->capacity;
+		atlas->verts = (SDL_Vertex*) realloc(atlas->verts, sizeof(*atlas->verts) * 4 * atlas->capacity); // SDL_Vertex*
+		atlas->indices = (int*) realloc(atlas->indices, sizeof(*atlas->indices) * 6 * atlas->capacity); // int*
+	}
+
+	int tw, th;
+	SDL_QueryTexture(atlas->texture, NULL, NULL, &tw, &th);
+
+	float pen = x;
+	int nglyphs = 0;
+	for (int i = 0; i < len; i++) {
+		const unsigned char c = (unsigned char) text[i];
+		const int g = (c >= GRAPHING_ATLAS_FIRST && c <= GRAPHING_ATLAS_LAST) ? c - GRAPHING_ATLAS_FIRST : '?' - GRAPHING_ATLAS_FIRST;
+		const SDL_Rect r = atlas->glyphs[g];
+
+		if (r.w > 0 && r.h > 0) {
+			const float u0 = (float) r.x / tw, u1 = (float)(r.x + r.w) / tw;
+			const float v0 = (float) r.y / th, v1 = (float)(r.y + r.h) / th;
+			SDL_Vertex* v = &atlas->verts[4 * nglyphs];
+			v[0] = (SDL_Vertex){{pen, y}, color, {u0, v0}};
+			v[1] = (SDL_Vertex){{pen + r.w, y}, color, {u1, v0}};
+			v[2] = (SDL_Vertex){{pen + r.w, y + r.h}, color, {u1, v1}};
+			v[3] = (SDL_Vertex){{pen, y + r.h}, color, {u0, v1}};
+
+			int* idx = &atlas->indices[6 * nglyphs];
+			const int b = 4 * nglyphs;
+			idx[0] = b; idx[1] = b + 1; idx[2] = b + 2;
+			idx[3] = b; idx[4] = b + 2; idx[5] = b + 3;
+			nglyphs++;
+		}
+		pen += atlas->advance[g];
+	}
+
+	if (nglyphs > 0)
+		SDL_RenderGeometry(renderer, atlas->texture, atlas->verts, 4 * nglyphs, atlas->indices, 6 * nglyphs);
+	return (int)(pen - x);
+}
+
+
+/*
+ *  Picks the grid for ngraphs tiles of tile_width x tile_height: `rows` per
+ *  column if that fits into the display's usable area, otherwise the
+ *  rows/columns split that needs the least shrinking of the tiles. The window
+ *  presents without vsync, its render loop does the pacing.
+ */
+graph_dashboard_t* graph_dashboard_create(const char* title, int ngraphs, int tile_width, int tile_height, int rows)
+{
+	if (ngraphs < 1)
+		ngraphs = 1;
+	if (rows < 1 || rows > ngraphs)
+		rows = ngraphs;
+
+	SDL_Rect bounds;
+	if (SDL_GetDisplayUsableBounds(0, &bounds) != 0)
+		bounds = (SDL_Rect){0, 0, INT32_MAX, INT32_MAX};
+
+	int columns = (ngraphs + rows - 1) / rows;
+	float scale = 1.0f;
+
+	if (columns * tile_width > bounds.w || rows * tile_height > bounds.h) {
+		scale = 0.0f;
+		for (int r = 1; r <= ngraphs; r++) {
+			const int c = (ngraphs + r - 1) / r;
+			float sx = (float)bounds.w / (c * tile_width);
+			float sy = (float)bounds.h / (r * tile_height);
+			float s = (sx < sy) ? sx : sy;
+			if (s > 1.0f)
+				s = 1.0f;
+			if (s > scale) {
+				scale = s;
+				rows = r;
+				columns = c;
+			}
+		}
+	}
+
+	// Too many tiles for the display to give each of them a plot
+	if ((int)(tile_width * scale) < GRAPHING_DASHBOARD_MIN_TILE || (int)(tile_height * scale) < GRAPHING_DASHBOARD_MIN_TILE) {
+		printf("Dashboard tiles would shrink to %dx%d px, below %d px!\n", (int)(tile_width * scale), (int)(tile_height * scale), GRAPHING_DASHBOARD_MIN_TILE);
+		return NULL;
+	}
+
+	graph_dashboard_t* dash = (graph_dashboard_t*) malloc(sizeof(*dash)); // graph_dashboard_t*
+	dash->tile_width = (int)(tile_width * scale);
+	dash->tile_height = (int)(tile_height * scale);
+	dash->rows = rows;
+	dash->columns = columns;
+	dash->scale = scale;
+	dash->pool = NULL;
+
+	int len = strlen(title);
+	char* wtitle = (char*) malloc(len + 1); // char*
+	snprintf(wtitle, len + 1, "%s", title);
+
+	if (create_window(&dash->window, wtitle, columns * dash->tile_width, rows * dash->tile_height, -1, -1, -1, 0) != 0) {
+		free(wtitle);
+		free(dash);
+		return NULL;
+	}
+	return dash;
+}
+
+
+/* Margins shrink along with the tiles, and further if they would leave no plot area */
+void graph_dashboard_place(graph_dashboard_t* dash, int i, graph_setup_t* setup)
+{
+	setup->dashboard = dash;
+	setup->width = dash->tile_width;
+	setup->height = dash->tile_height;
+	setup->xpos = (i / dash->rows) * dash->tile_width;
+	setup->ypos = (i % dash->rows) * dash->tile_height;
+
+	if (dash->scale < 1.0f) {
+		setup->xmargin = (int)(setup->xmargin * dash->scale);
+		setup->ymargin = (int)(setup->ymargin * dash->scale);
+		setup->_extended_ymargin = (int)(setup->_extended_ymargin * dash->scale);
+	}
+
+	// At least half of the tile is left to plot in
+	if (4 * setup->xmargin > setup->width)
+		setup->xmargin = setup->width / 4;
+	if (4 * (setup->ymargin + setup->_extended_ymargin) > setup->height) {
+		setup->ymargin = setup->height / 8;
+		setup->_extended_ymargin = setup->height / 8;
+	}
+}
+
+
+/* */
+int graph_dashboard_render(graph_dashboard_t* dash, graph_t** graphs, int ngraphs)
+{
+	if (!graph_dashboard_draw(dash, graphs, ngraphs))
+		return 0;
+
+	graph_dashboard_present(dash, graphs, ngraphs);
+	return 1;
+}
+
+
+/* The window is cleared every frame, so it's all tiles or none */
+int graph_dashboard_draw(graph_dashboard_t* dash, graph_t** graphs, int ngraphs)
+{
+	SDL_Renderer* renderer = dash->window.renderer;
+
+	uint8_t changed = 0;
+	for (int i = 0; i < ngraphs && !changed; i++)
+		changed = (graphs[i]->window.renderer == renderer) && graph_changed(graphs[i]);
+	if (!changed)
+		return 0;
+
+	SDL_RenderSetViewport(renderer, NULL);
+	SDL_SetRenderDrawColor(renderer, GRAPHING_DEFAULT_BG_COLOR, GRAPHING_DEFAULT_BG_ALPHA);
+	SDL_RenderClear(renderer);
+
+	if (dash->pool != NULL) {
+		graph_raster_draw_(dash->pool, graphs, ngraphs, renderer);
+	} else {
+		for (int i = 0; i < ngraphs; i++)
+			if (graphs[i]->window.renderer == renderer)
+				graph_draw(graphs[i]);
+	}
+
+	SDL_RenderSetViewport(renderer, NULL);
+	return 1;
+}
+
+
+/* */
+void graph_dashboard_present(graph_dashboard_t* dash, graph_t** graphs, int ngraphs)
+{
+	SDL_Renderer* renderer = dash->window.renderer;
+
+	SDL_RenderPresent(renderer);
+	window_count_frame_(&dash->window);
+
+	for (int i = 0; i < ngraphs; i++)
+		if (graphs[i]->window.renderer == renderer)
+			graphs[i]->window.achieved_fps = dash->window.achieved_fps;
+}
+
+
+/* */
+void graph_dashboard_handle_event(graph_dashboard_t* dash, graph_t** graphs, int ngraphs, const SDL_Event* e)
+{
+	if (!window_handle_event_(&dash->window, e))
+		return;
+
+	for (int i = 0; i < ngraphs; i++)
+		if (graphs[i]->window.renderer == dash->window.renderer)
+			graph_invalidate(graphs[i]);
+}
+
+
+/* */
+uint8_t graph_dashboard_due(graph_dashboard_t* dash)
+{
+	return window_due_(&dash->window);
+}
+
+
+/* */
+void graph_dashboard_destroy(graph_dashboard_t* dash)
+{
+	if (dash == NULL)
+		return;
+
+	close_window(&dash->window);
+	free(dash->window.title);
+	free(dash);
 }
 
 
@@ -885,6 +3405,7 @@ void graph_shutdown()
 			free(elem_ss);
 		}
 	#endif
+	graph_atlas_release_(NULL, NULL);
 
 	// Destroy SDL
 	// SDLNet_Quit();
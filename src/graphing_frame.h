@@ -0,0 +1,65 @@
+/*
+ *	Copyright (c) 2023-2024 Fran Tomljenović
+ *
+ *	Binary frame format read by `graphing --binary`.
+ *	================================================
+ *	A frame is a 12 byte header followed by `samples` rows of `channels`
+ *	values each (row-major, same order as a text line), all little-endian:
+ *
+ *	  offset  size  field
+ *	  0       4     magic     'G' 'R' 'P' 'H'
+ *	  4       2     channels  values per row
+ *	  6       2     dtype     GRAPHING_DTYPE_*
+ *	  8       4     samples   rows in this frame
+ *	  12      ...   samples * channels * graphing_dtype_size(dtype) bytes
+ *
+ *	Put as many rows into one frame as you have at hand, header cost is paid
+ *	per frame and not per row. If the stream gets out of sync the reader
+ *	skips ahead to the next magic.
+ *
+ *	Only plain C, no SDL needed, so producers may include it on its own.
+ */
+
+#ifndef __GRAPHING_FRAME_H_
+#define __GRAPHING_FRAME_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define GRAPHING_FRAME_MAGIC        "GRPH"
+#define GRAPHING_FRAME_HEADER_SIZE  12
+
+#define GRAPHING_DTYPE_F32          1
+#define GRAPHING_DTYPE_I16          2
+#define GRAPHING_DTYPE_I32          3
+
+typedef struct {
+	char magic[4];
+	uint16_t channels;
+	uint16_t dtype;
+	uint32_t samples;
+} graphing_frame_header_t;
+
+
+/* Size of one value in bytes, 0 if dtype is unknown */
+static inline int graphing_dtype_size(int dtype)
+{
+	switch (dtype) {
+		case GRAPHING_DTYPE_F32: return 4;
+		case GRAPHING_DTYPE_I16: return 2;
+		case GRAPHING_DTYPE_I32: return 4;
+	}
+	return 0;
+}
+
+
+/* Fills a header for a frame of `samples` rows (host is assumed little-endian) */
+static inline void graphing_frame_header(graphing_frame_header_t* hdr, uint16_t channels, uint16_t dtype, uint32_t samples)
+{
+	memcpy(hdr->magic, GRAPHING_FRAME_MAGIC, 4);
+	hdr->channels = channels;
+	hdr->dtype = dtype;
+	hdr->samples = samples;
+}
+
+#endif //__GRAPHING_FRAME_H_
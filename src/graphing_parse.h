@@ -0,0 +1,179 @@
+/*
+ *	Copyright (c) 2023-2024 Fran Tomljenović
+ *
+ *	Delimited text rows parsed in place, used by `graphing` for stdin, UDP and --file.
+ *	===================================================================================
+ *	Lines are parsed in place, without splitting them into separate strings
+ *	first. Every field is read with parse_float() and the parser then expects
+ *	to find the delimiter right where the number ended, so on well-formed input
+ *	each byte of the line is looked at only once. Anything unusual (garbage
+ *	between fields, inf/nan/hex values) falls back to a memchr() scan for the
+ *	next delimiter (vectorized by libc) and to strtof() for the value itself.
+ *
+ *	Only plain C, no SDL needed; examples/bench_parse measures it.
+ */
+
+#ifndef __GRAPHING_PARSE_H_
+#define __GRAPHING_PARSE_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double g_pow10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+/* Locale independent strtof() for plain decimal numbers; returns the end of the number
+ * or NULL if [p, end) does not start with one (caller should then use strtof()) */
+static inline const char* parse_float(const char* p, const char* end, float* out)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+
+	uint8_t neg = 0;
+	if (p < end && (*p == '-' || *p == '+'))
+		neg = (*p++ == '-');
+
+	uint64_t mant = 0;
+	int ndigits = 0; // significant digits stored in mant
+	int exp10 = 0;
+	uint8_t any = 0;
+
+	// Integer part
+	for (; p < end && (unsigned)(*p - '0') < 10; p++, any = 1) {
+		if (ndigits < 19) {
+			mant = mant * 10 + (*p - '0');
+			ndigits += (mant != 0);
+		} else {
+			exp10++; // ran out of precision, only keep the magnitude
+		}
+	}
+
+	// Fraction
+	if (p < end && *p == '.') {
+		for (p++; p < end && (unsigned)(*p - '0') < 10; p++, any = 1) {
+			if (ndigits < 19) {
+				mant = mant * 10 + (*p - '0');
+				ndigits += (mant != 0);
+				exp10--;
+			}
+		}
+	}
+
+	if (!any)
+		return NULL;
+
+	// Exponent
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* ep = p + 1;
+		uint8_t eneg = 0;
+		if (ep < end && (*ep == '-' || *ep == '+'))
+			eneg = (*ep++ == '-');
+
+		if (ep < end && (unsigned)(*ep - '0') < 10) {
+			int e = 0;
+			for (; ep < end && (unsigned)(*ep - '0') < 10; ep++)
+				if (e < 10000)
+					e = e * 10 + (*ep - '0');
+			exp10 += eneg ? -e : e;
+			p = ep;
+		}
+	}
+
+	// Exact for up to 15 digits and |exp10| <= 22, close enough otherwise
+	double val = (double)mant;
+	if (mant != 0) {
+		for (; exp10 > 22 && val < 1e300; exp10 -= 22)
+			val *= 1e22;
+		for (; exp10 < -22 && val > 1e-300; exp10 += 22)
+			val /= 1e22;
+
+		if (exp10 > 0)
+			val *= g_pow10[exp10 > 22 ? 22 : exp10];
+		else if (exp10 < 0)
+			val /= g_pow10[exp10 < -22 ? 22 : -exp10];
+	}
+
+	*out = (float)(neg ? -val : val);
+	return p;
+}
+
+
+/* Parses delimited floats from [line, end) into out[0..nout); returns how many fields were
+ * found (at most nout). Never allocates. */
+static inline int parse_row(const char* line, const char* end, const char* delim, size_t delim_len, float* out, int nout)
+{
+	// Ignore trailing whitespace/CR so a CRLF line ends exactly at its last number
+	while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+		end--;
+
+	int count = 0;
+	const char* p = line;
+
+	while (count < nout && p < end) {
+		const char* num_end = parse_float(p, end, &out[count]);
+
+		// Fast path: number is directly followed by the delimiter or end of line
+		if (num_end != NULL) {
+			if (num_end == end) {
+				count++;
+				break;
+			}
+			if ((size_t)(end - num_end) >= delim_len && memcmp(num_end, delim, delim_len) == 0) {
+				count++;
+				p = num_end + delim_len;
+				continue;
+			}
+		}
+
+		// Slow path: find the end of the field and let strtof() figure it out
+		const char* field_end = end;
+		for (const char* s = p; (s = (const char*) memchr(s, delim[0], end - s)) != NULL; s++) {
+			if ((size_t)(end - s) >= delim_len && memcmp(s, delim, delim_len) == 0) {
+				field_end = s;
+				break;
+			}
+		}
+
+		char tmp[64];
+		size_t flen = field_end - p;
+		if (flen >= sizeof(tmp))
+			flen = sizeof(tmp) - 1;
+		memcpy(tmp, p, flen);
+		tmp[flen] = '\0';
+		out[count++] = strtof(tmp, NULL);
+
+		if (field_end == end)
+			break;
+		p = field_end + delim_len;
+	}
+
+	return count;
+}
+
+
+/* Whether parse_row() would find at least nfields fields in [line, end), without parsing them */
+static inline int row_has_fields(const char* line, const char* end, const char* delim, size_t delim_len, int nfields)
+{
+	while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+		end--;
+	if (line == end)
+		return 0;
+
+	// Every delimiter before the end starts another field
+	int count = 1;
+	for (const char* s = line; count < nfields && (s = (const char*) memchr(s, delim[0], end - s)) != NULL; s++) {
+		if ((size_t)(end - s) >= delim_len && memcmp(s, delim, delim_len) == 0) {
+			if (s + delim_len == end)
+				break;
+			count++;
+			s += delim_len - 1;
+		}
+	}
+	return count >= nfields;
+}
+
+#endif //__GRAPHING_PARSE_H_
@@ -0,0 +1,276 @@
+/*
+ *	Copyright (c) 2023-2024 Fran Tomljenović
+ *
+ *	Shared-memory sample ring read by `graphing --shm <name>` (POSIX only).
+ *	=======================================================================
+ *	A producer on the same machine creates a named segment and pushes rows of
+ *	`channels` floats into it; graphing maps the same segment and drains it.
+ *	The ring is single-producer/single-consumer and lock-free: pushing a row
+ *	is a memcpy and one atomic store, no syscalls, no formatting, no pipe.
+ *	If the ring is full the row is dropped and push returns 0. A producer that
+ *	restarts and recreates the segment bumps its generation, attached consumers
+ *	notice with graphing_shm_stale() and map it again.
+ *
+ *	Producer:
+ *	  graphing_shm_t* shm = graphing_shm_create("/mysensor", 24, 1 << 16);
+ *	  ...
+ *	  graphing_shm_push(shm, row);          // row = float[24]
+ *	  ...
+ *	  graphing_shm_close(shm);              // also removes the segment
+ *
+ *	Plain C, no SDL needed. May need -lrt on older glibc.
+ */
+
+#ifndef __GRAPHING_SHM_H_
+#define __GRAPHING_SHM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GRAPHING_SHM_MAGIC      0x4D485347u // "GSHM"
+#define GRAPHING_SHM_VERSION    1
+
+// Lives at the start of the segment; rows follow right after it
+typedef struct {
+	uint32_t magic;             // written last by the producer, segment is ready once it's set
+	uint32_t version;
+	uint32_t channels;          // floats per row
+	uint32_t capacity;          // rows, power of two
+	uint32_t closed;            // producer has gone away
+	uint32_t generation;        // bumped every time a producer (re)creates the segment
+	char _pad0[64 - 24];
+
+	uint64_t head;              // rows written, only the producer stores here
+	char _pad1[64 - 8];
+
+	uint64_t tail;              // rows read, only the consumer stores here
+	char _pad2[64 - 8];
+} graphing_shm_header_t;
+
+typedef struct {
+	graphing_shm_header_t* hdr;
+	float* rows;
+	size_t size;
+	uint64_t cached;            // last seen value of the other side's index
+	uint32_t channels;          // copied from the header when mapped, so a producer recreating
+	uint32_t capacity;          //   the segment can't make us index past our mapping
+	uint32_t generation;
+	uint8_t owner;
+	char name[255+1];
+} graphing_shm_t;
+
+
+/* */
+static inline graphing_shm_t* graphing_shm_map_(const char* name, int fd, size_t size, uint8_t owner)
+{
+	void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	graphing_shm_t* shm = (graphing_shm_t*) malloc(sizeof(*shm));
+	shm->hdr = (graphing_shm_header_t*) mem;
+	shm->rows = (float*)((char*) mem + sizeof(graphing_shm_header_t));
+	shm->size = size;
+	shm->cached = 0;
+	shm->channels = 0;
+	shm->capacity = 0;
+	shm->generation = 0;
+	shm->owner = owner;
+	snprintf(shm->name, sizeof(shm->name), "%s", name);
+	return shm;
+}
+
+
+/* Producer: creates (or recreates) segment `name` for rows of `channels` floats;
+ * capacity is rounded up to a power of two. A segment left behind is never shrunk,
+ * consumers still mapping it must not fault before they notice the new generation */
+static inline graphing_shm_t* graphing_shm_create(const char* name, uint32_t channels, uint32_t capacity)
+{
+	uint32_t cap = 1;
+	while (cap < capacity)
+		cap <<= 1;
+
+	size_t size = sizeof(graphing_shm_header_t) + (size_t) cap * channels * sizeof(float);
+
+	int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return NULL;
+	}
+	if ((size_t) st.st_size > size)
+		size = (size_t) st.st_size;
+	if (ftruncate(fd, (off_t) size) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	graphing_shm_t* shm = graphing_shm_map_(name, fd, size, 1);
+	if (shm == NULL)
+		return NULL;
+
+	// A new segment reads as generation 0, so the first one is 1; it's bumped before anything
+	// else changes, so a consumer still seeing the old one has read the old header
+	graphing_shm_header_t* hdr = shm->hdr;
+	const uint32_t generation = __atomic_load_n(&hdr->generation, __ATOMIC_RELAXED) + 1;
+	__atomic_store_n(&hdr->magic, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&hdr->generation, generation, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	hdr->version = GRAPHING_SHM_VERSION;
+	hdr->channels = channels;
+	hdr->capacity = cap;
+	hdr->closed = 0;
+	hdr->head = 0;
+	hdr->tail = 0;
+	__atomic_store_n(&hdr->magic, GRAPHING_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	shm->channels = channels;
+	shm->capacity = cap;
+	shm->generation = generation;
+	return shm;
+}
+
+
+/* Consumer: 1 once the segment mapped isn't the one attached to anymore, a producer has
+ * recreated it (or is doing so) and it has to be closed and opened again */
+static inline int graphing_shm_stale(graphing_shm_t* shm)
+{
+	graphing_shm_header_t* hdr = shm->hdr;
+	return __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != GRAPHING_SHM_MAGIC
+		|| __atomic_load_n(&hdr->generation, __ATOMIC_ACQUIRE) != shm->generation;
+}
+
+
+/* Consumer: maps an existing segment, NULL if it isn't there (yet) or isn't ours */
+static inline graphing_shm_t* graphing_shm_open(const char* name)
+{
+	int fd = shm_open(name, O_RDWR, 0600);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(graphing_shm_header_t)) {
+		close(fd);
+		return NULL;
+	}
+
+	graphing_shm_t* shm = graphing_shm_map_(name, fd, (size_t) st.st_size, 0);
+	if (shm == NULL)
+		return NULL;
+
+	// Checked on the copies, then the generation again: a producer recreating the segment
+	// meanwhile could have changed the header under us
+	graphing_shm_header_t* hdr = shm->hdr;
+	const uint32_t magic = __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE);
+	shm->generation = __atomic_load_n(&hdr->generation, __ATOMIC_ACQUIRE);
+	shm->channels = hdr->channels;
+	shm->capacity = hdr->capacity;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (magic != GRAPHING_SHM_MAGIC || hdr->version != GRAPHING_SHM_VERSION || shm->channels == 0
+		|| shm->capacity == 0 || (shm->capacity & (shm->capacity - 1)) != 0
+		|| shm->size < sizeof(*hdr) + (size_t) shm->capacity * shm->channels * sizeof(float)
+		|| graphing_shm_stale(shm)) {
+		munmap(shm->hdr, shm->size);
+		free(shm);
+		return NULL;
+	}
+	return shm;
+}
+
+
+/* Producer: copies up to n rows into the ring; returns how many fit */
+static inline uint32_t graphing_shm_push_rows(graphing_shm_t* shm, const float* rows, uint32_t n)
+{
+	graphing_shm_header_t* hdr = shm->hdr;
+	const uint32_t ch = shm->channels;
+	const uint32_t cap = shm->capacity;
+	const uint64_t head = hdr->head;
+
+	// Only look at the consumer's index when the cached one says we're full
+	if (head + n - shm->cached > cap)
+		shm->cached = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+
+	uint64_t space = cap - (head - shm->cached);
+	if (n > space)
+		n = (uint32_t) space;
+	if (n == 0)
+		return 0;
+
+	uint32_t at = (uint32_t)(head & (cap - 1));
+	uint32_t first = (n < cap - at) ? n : cap - at;
+	memcpy(shm->rows + (size_t) at * ch, rows, (size_t) first * ch * sizeof(float));
+	memcpy(shm->rows, rows + (size_t) first * ch, (size_t)(n - first) * ch * sizeof(float));
+
+	__atomic_store_n(&hdr->head, head + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+
+/* Producer: pushes a single row of `channels` floats; returns 0 if the ring was full */
+static inline int graphing_shm_push(graphing_shm_t* shm, const float* row)
+{
+	return (int) graphing_shm_push_rows(shm, row, 1);
+}
+
+
+/* Consumer: points *rows at the oldest unread rows; returns how many are readable in one
+ * contiguous run (call again after graphing_shm_release() for the part after the wrap) */
+static inline uint32_t graphing_shm_peek(graphing_shm_t* shm, const float** rows)
+{
+	graphing_shm_header_t* hdr = shm->hdr;
+	const uint32_t cap = shm->capacity;
+	const uint64_t tail = hdr->tail;
+
+	if (shm->cached == tail)
+		shm->cached = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+
+	uint32_t at = (uint32_t)(tail & (cap - 1));
+	uint64_t avail = shm->cached - tail;
+	if (avail > cap - at)
+		avail = cap - at;
+
+	*rows = shm->rows + (size_t) at * shm->channels;
+	return (uint32_t) avail;
+}
+
+
+/* Consumer: marks n rows returned by graphing_shm_peek() as read */
+static inline void graphing_shm_release(graphing_shm_t* shm, uint32_t n)
+{
+	__atomic_store_n(&shm->hdr->tail, shm->hdr->tail + n, __ATOMIC_RELEASE);
+}
+
+
+/* Unmaps the segment; the producer also flags it closed and removes its name */
+static inline void graphing_shm_close(graphing_shm_t* shm)
+{
+	if (shm == NULL)
+		return;
+
+	if (shm->owner) {
+		__atomic_store_n(&shm->hdr->closed, 1, __ATOMIC_RELEASE);
+		shm_unlink(shm->name);
+	}
+	munmap(shm->hdr, shm->size);
+	free(shm);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__GRAPHING_SHM_H_